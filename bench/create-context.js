@@ -0,0 +1,47 @@
+'use strict'
+
+// Measures how long creating and destroying a context takes. The first
+// context of each WebGL version pays for loading ANGLE and filling the
+// per-display caches, so it is reported separately.
+//
+//   node bench/create-context.js [iterations]
+
+const { performance } = require('perf_hooks')
+const createContext = require('../index')
+
+const iterations = (process.argv[2] | 0) || 200
+
+function percentile (sorted, p) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))]
+}
+
+function run (name, options) {
+  let start = performance.now()
+  const first = createContext(64, 64, options)
+  const firstMs = performance.now() - start
+  first.destroy()
+
+  const createMs = []
+  const destroyMs = []
+  for (let i = 0; i < iterations; ++i) {
+    start = performance.now()
+    const gl = createContext(64, 64, options)
+    createMs.push(performance.now() - start)
+
+    start = performance.now()
+    gl.destroy()
+    destroyMs.push(performance.now() - start)
+  }
+  createMs.sort((a, b) => a - b)
+  destroyMs.sort((a, b) => a - b)
+
+  console.log(name)
+  console.log('  first create   %s ms', firstMs.toFixed(3))
+  console.log('  create   p50 %s ms  p95 %s ms', percentile(createMs, 0.5).toFixed(3),
+    percentile(createMs, 0.95).toFixed(3))
+  console.log('  destroy  p50 %s ms  p95 %s ms', percentile(destroyMs, 0.5).toFixed(3),
+    percentile(destroyMs, 0.95).toFixed(3))
+}
+
+run('webgl', {})
+run('webgl2', { createWebGL2Context: true })
@@ -0,0 +1,59 @@
+'use strict'
+
+// Measures how long destroying a context full of objects takes, which is
+// dominated by deleting the GL objects it still holds.
+//
+//   node bench/teardown.js [objects] [iterations]
+
+const { performance } = require('perf_hooks')
+const createContext = require('../index')
+
+const objects = (process.argv[2] | 0) || 10000
+const iterations = (process.argv[3] | 0) || 20
+
+function percentile (sorted, p) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))]
+}
+
+function populate (gl) {
+  const data = new Uint8Array(64)
+  for (let i = 0; i < objects; ++i) {
+    const buffer = gl.createBuffer()
+    gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+    gl.bufferData(gl.ARRAY_BUFFER, data, gl.STATIC_DRAW)
+
+    const texture = gl.createTexture()
+    gl.bindTexture(gl.TEXTURE_2D, texture)
+    gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, data)
+
+    const renderbuffer = gl.createRenderbuffer()
+    gl.bindRenderbuffer(gl.RENDERBUFFER, renderbuffer)
+    gl.renderbufferStorage(gl.RENDERBUFFER, gl.RGBA4, 4, 4)
+
+    gl.createFramebuffer()
+  }
+  gl.bindBuffer(gl.ARRAY_BUFFER, null)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  gl.bindRenderbuffer(gl.RENDERBUFFER, null)
+}
+
+function run (name, options) {
+  const destroyMs = []
+  for (let i = 0; i < iterations; ++i) {
+    const gl = createContext(64, 64, options)
+    populate(gl)
+    gl.finish()
+
+    const start = performance.now()
+    gl.destroy()
+    destroyMs.push(performance.now() - start)
+  }
+  destroyMs.sort((a, b) => a - b)
+
+  console.log('%s, %d objects of each type', name, objects)
+  console.log('  destroy  p50 %s ms  p95 %s ms', percentile(destroyMs, 0.5).toFixed(3),
+    percentile(destroyMs, 0.95).toFixed(3))
+}
+
+run('webgl', {})
+run('webgl2', { createWebGL2Context: true })
@@ -17,6 +17,8 @@
           'src/native/bindings.cc',
           'src/native/webgl.cc',
           'src/native/SharedLibrary.cc',
+          'src/native/ProgramCache.cc',
+          'src/native/ShaderStats.cc',
           'src/native/angle-loader/egl_loader.cc',
           'src/native/angle-loader/gles_loader.cc'
       ],
@@ -37,7 +39,7 @@
             'xcode_settings': {
               'GCC_ENABLE_CPP_RTTI': 'YES',
               'GCC_ENABLE_CPP_EXCEPTIONS': 'YES',
-              'MACOSX_DEPLOYMENT_TARGET':'10.8',
+              'MACOSX_DEPLOYMENT_TARGET':'10.15',
               'CLANG_CXX_LIBRARY': 'libc++',
               'CLANG_CXX_LANGUAGE_STANDARD':'c++20',
               'GCC_VERSION': 'com.apple.compilers.llvm.clang.1_0'
@@ -7,9 +7,165 @@ declare namespace createContext {
       resize(width: GLint, height: GLint): void;
   }
 
+  interface TextureStorageStats {
+      promotedTextures: number;
+      avoidedReallocations: number;
+      demotedMipChains: number;
+      pendingMipChains: number;
+  }
+
+  interface TextureMemoryStats {
+      budget: number;
+      residentBytes: number;
+      evictableTextures: number;
+      evictedTextures: number;
+      evictions: number;
+      restores: number;
+      evictedBytes: number;
+      restoredBytes: number;
+  }
+
+  interface MemoryTotals {
+      count: number;
+      bytes: number;
+  }
+
+  interface MemoryInfo {
+      buffers: MemoryTotals;
+      textures: MemoryTotals;
+      renderbuffers: MemoryTotals;
+      framebuffers: MemoryTotals;
+      programs: MemoryTotals;
+      shaders: MemoryTotals;
+      vertexArrays: MemoryTotals;
+      drawingBufferBytes: number;
+      totalBytes: number;
+      limit: number;
+  }
+
+  type TextureSource = (
+      { data: ArrayBuffer | SharedArrayBuffer | ArrayBufferView } |
+      { path: string; offset?: number; length?: number } |
+      { load(): ArrayBuffer | SharedArrayBuffer | ArrayBufferView }
+  ) & { compression?: "gzip" | "deflate" | "brotli" };
+
+  interface TextureLayers {
+      buffer: ArrayBuffer | SharedArrayBuffer | ArrayBufferView;
+      offsets: ArrayLike<number>;
+  }
+
+  interface ProgramCacheOptions {
+      dir?: string;
+      maxBytes?: number;
+      memoryBytes?: number;
+  }
+
+  interface ProgramCacheStats {
+      enabled: boolean;
+      dir: string;
+      hits: number;
+      misses: number;
+      writes: number;
+      evictions: number;
+      bytes: number;
+      memoryBytes: number;
+      savedMs: number;
+  }
+
+  interface ShaderStatsEntry {
+      hash: string;
+      sourceBytes: number;
+      count: number;
+      totalMs: number;
+      maxMs: number;
+  }
+
+  interface ShaderHistogram {
+      count: number;
+      sum: number;
+      min: number;
+      max: number;
+  }
+
+  interface ShaderStats {
+      shaders: Array<ShaderStatsEntry & { type: GLenum; shaders: WebGLShader[] }>;
+      programs: Array<ShaderStatsEntry & { programs: WebGLProgram[] }>;
+      histograms: { [name: string]: ShaderHistogram };
+  }
+
+  interface WarmProgram {
+      id: string;
+      vertex: string;
+      fragment: string;
+      attributes?: { [name: string]: number };
+  }
+
+  interface ShaderTemplate {
+      vertex: string;
+      fragment: string;
+      attributes?: { [name: string]: number };
+      features?: string[];
+  }
+
+  type ShaderDefines = { [feature: string]: boolean | number | string | null | undefined };
+
+  interface MemoryPressureOptions {
+      rss?: number;
+      heapUsed?: number;
+      level?: 1 | 2;
+  }
+
+  interface ContextOptions {
+      promoteTextureStorage?: boolean;
+      memoryBudget?: number;
+      memoryLimit?: number;
+      reclaimObjects?: boolean;
+      memoryPressure?: MemoryPressureOptions;
+      drawingBuffer?: boolean;
+      programCache?: ProgramCacheOptions | boolean;
+      warmPrograms?: WarmProgram[];
+      shareWith?: WebGLRenderingContext | WebGL2RenderingContext;
+  }
+
+  interface ContextPoolOptions {
+      size?: number;
+      width: number;
+      height: number;
+      attributes?: WebGLContextAttributes & Omit<ContextOptions, 'shareWith'> & { createWebGL2Context?: boolean };
+  }
+
+  interface ContextPool {
+      acquire(width?: number, height?: number): (WebGLRenderingContext | WebGL2RenderingContext) & StackGLExtension | null;
+      release(gl: (WebGLRenderingContext | WebGL2RenderingContext) & StackGLExtension): void;
+      destroy(): void;
+  }
+
+  function createContextPool(options: ContextPoolOptions): ContextPool;
+
+  function trimProgramCache(): number;
+
   interface StackGLExtension {
       getExtension(extensionName: "STACKGL_destroy_context"): STACKGL_destroy_context | null;
       getExtension(extensionName: "STACKGL_resize_drawingbuffer"): STACKGL_resize_drawingbuffer | null;
+      getTextureStorageStats(): TextureStorageStats;
+      setTextureEvictable(texture: WebGLTexture, source: TextureSource | null): void;
+      getTextureMemoryStats(): TextureMemoryStats;
+      getMemoryInfo(): MemoryInfo;
+      trimMemory(level?: 1 | 2): number;
+      getProgramCacheStats(): ProgramCacheStats;
+      linkProgramAsync(program: WebGLProgram): Promise<boolean>;
+      getWarmProgram(id: string): WebGLProgram | null;
+      registerShaderTemplate(id: string, template: ShaderTemplate): void;
+      getVariant(id: string, defines?: ShaderDefines): WebGLProgram | null;
+      getVariantAsync(id: string, defines?: ShaderDefines): Promise<WebGLProgram | null>;
+      getShaderStats(): ShaderStats;
+      texSubImage3DLayers(
+          target: GLenum, level: GLint,
+          xoffset: GLint, yoffset: GLint, zoffset: GLint,
+          width: GLsizei, height: GLsizei,
+          format: GLenum, type: GLenum,
+          layers: (ArrayBuffer | SharedArrayBuffer | ArrayBufferView)[] | TextureLayers,
+      ): void;
   }
 
   const WebGLRenderingContext: WebGLRenderingContext & StackGLExtension & {
@@ -26,19 +182,19 @@ declare namespace createContext {
 declare function createContext(
   width: number,
   height: number,
-  options?: WebGLContextAttributes & { createWebGL2Context?: false },
+  options?: WebGLContextAttributes & createContext.ContextOptions & { createWebGL2Context?: false },
 ): WebGLRenderingContext & createContext.StackGLExtension;
 
 declare function createContext(
   width: number,
   height: number,
-  options: WebGLContextAttributes & { createWebGL2Context: true }
+  options: WebGLContextAttributes & createContext.ContextOptions & { createWebGL2Context: true }
 ): WebGL2RenderingContext & createContext.StackGLExtension;
 
 declare function createContext(
   width: number,
   height: number,
-  options?: WebGLContextAttributes & { createWebGL2Context?: boolean }
+  options?: WebGLContextAttributes & createContext.ContextOptions & { createWebGL2Context?: boolean }
 ): (WebGLRenderingContext | WebGL2RenderingContext) & createContext.StackGLExtension;
 
 export = createContext;
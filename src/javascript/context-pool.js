@@ -0,0 +1,98 @@
+const createContext = require('./node-index')
+const { unwrapContext } = require('./webgl-rendering-context')
+
+// Contexts created ahead of time for servers that render one request at a
+// time. Releasing a context resets it natively, deleting the objects the
+// request created and restoring the default GL state, which costs far less
+// than creating a new context for the next request.
+class WebGLContextPool {
+  constructor (size, width, height, attributes) {
+    this._size = size
+    this._width = width
+    this._height = height
+    this._attributes = attributes
+    this._free = []
+    this._busy = new Set()
+
+    for (let i = 0; i < size; ++i) {
+      const gl = createContext(width, height, attributes)
+      if (!gl) {
+        break
+      }
+      this._free.push(gl)
+    }
+  }
+
+  // Returns a context in the state of a new one, with a drawing buffer of the
+  // given size. Contexts are created on demand once the pool is empty.
+  acquire (width = this._width, height = this._height) {
+    let gl = this._free.pop()
+    if (!gl) {
+      gl = createContext(width, height, this._attributes)
+      if (!gl) {
+        return null
+      }
+    } else {
+      gl.resize(width, height)
+    }
+    this._busy.add(gl)
+    return gl
+  }
+
+  release (gl) {
+    if (!this._busy.delete(gl)) {
+      throw new TypeError('release(gl) expects a context acquired from this pool')
+    }
+    const ctx = unwrapContext(gl)
+    // Another context joined its share group with shareWith, and still uses
+    // the objects a reset would delete
+    if (this._free.length >= this._size ||
+      (ctx._shareGroup && ctx._shareGroup._contexts.size > 1)) {
+      gl.destroy()
+      return
+    }
+    try {
+      ctx._resetState(ctx.drawingBufferWidth, ctx.drawingBufferHeight)
+    } catch (e) {
+      // Destroyed by the application
+      return
+    }
+    const warmPrograms = this._attributes && this._attributes.warmPrograms
+    if (warmPrograms) {
+      ctx._warmUpPrograms(warmPrograms)
+    }
+    this._free.push(gl)
+  }
+
+  // Destroys the contexts of the pool, including those still acquired
+  destroy () {
+    for (const gl of this._free.concat(Array.from(this._busy))) {
+      try {
+        gl.destroy()
+      } catch (e) {
+        // Already destroyed by the application
+      }
+    }
+    this._free = []
+    this._busy.clear()
+  }
+}
+
+function createContextPool (options) {
+  options = options || {}
+  const size = options.size === undefined ? 1 : options.size | 0
+  const width = options.width | 0
+  const height = options.height | 0
+  if (!(size >= 0 && width > 0 && height > 0)) {
+    throw new TypeError('createContextPool({ size, width, height, attributes })')
+  }
+  // Releasing a context deletes every object of its share group, which would
+  // pull them out from under the other contexts of the group
+  if (options.attributes && typeof options.attributes === 'object' &&
+    options.attributes.shareWith !== undefined && options.attributes.shareWith !== null) {
+    throw new TypeError('createContextPool does not support shareWith')
+  }
+  return new WebGLContextPool(size, width, height, options.attributes)
+}
+
+module.exports = { createContextPool, WebGLContextPool }
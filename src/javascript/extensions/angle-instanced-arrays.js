@@ -11,10 +11,12 @@ class ANGLEInstancedArrays {
   }
 
   drawArraysInstancedANGLE (mode, first, count, primCount) {
+    this.ctx._ensureDrawingBuffer()
     this._drawArraysInstancedANGLE(mode, first, count, primCount)
   }
 
   drawElementsInstancedANGLE (mode, count, type, ioffset, primCount) {
+    this.ctx._ensureDrawingBuffer()
     this._drawElementsInstancedANGLE(mode, count, type, ioffset, primCount)
   }
 
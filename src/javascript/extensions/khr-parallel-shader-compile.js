@@ -0,0 +1,28 @@
+const { gl } = require('../native-gl')
+
+class KHRParallelShaderCompile {
+  constructor (ctx) {
+    this.MAX_SHADER_COMPILER_THREADS_KHR = 0x91B0
+    this.COMPLETION_STATUS_KHR = 0x91B1
+    this.ctx = ctx
+
+    this._maxShaderCompilerThreadsKHR = gl._maxShaderCompilerThreadsKHR.bind(ctx)
+  }
+
+  maxShaderCompilerThreadsKHR (count) {
+    this._maxShaderCompilerThreadsKHR(count >>> 0)
+  }
+}
+
+function getKHRParallelShaderCompile (ctx) {
+  let result = null
+  const exts = ctx.getSupportedExtensions()
+
+  if (exts && exts.indexOf('KHR_parallel_shader_compile') >= 0) {
+    result = new KHRParallelShaderCompile(ctx)
+  }
+
+  return result
+}
+
+module.exports = { getKHRParallelShaderCompile, KHRParallelShaderCompile }
@@ -0,0 +1,62 @@
+// Trims the memory of contexts created with the memoryPressure option once the
+// process goes over one of their thresholds. A single timer, which doesn't
+// keep the process alive, samples process.memoryUsage() for all of them.
+// Contexts are trimmed once each time usage crosses a threshold, not again
+// until it has dropped back under.
+const INTERVAL = 1000
+
+const watched = new Set()
+let timer = null
+
+function check () {
+  const usage = process.memoryUsage()
+  for (const entry of watched) {
+    const ctx = entry.ref.deref()
+    if (!ctx) {
+      watched.delete(entry)
+      continue
+    }
+    const over = usage.rss > entry.rss || usage.heapUsed > entry.heapUsed
+    if (over && !entry.over) {
+      ctx.trimMemory(entry.level)
+    }
+    entry.over = over
+  }
+  if (watched.size === 0) {
+    clearInterval(timer)
+    timer = null
+  }
+}
+
+function watchMemoryPressure (ctx, options) {
+  if (!options || typeof options !== 'object') {
+    return
+  }
+  const rss = +options.rss
+  const heapUsed = +options.heapUsed
+  const entry = {
+    ref: new WeakRef(ctx),
+    rss: rss > 0 ? rss : Infinity,
+    heapUsed: heapUsed > 0 ? heapUsed : Infinity,
+    level: options.level === undefined ? 1 : options.level | 0,
+    over: false
+  }
+  if (entry.rss === Infinity && entry.heapUsed === Infinity) {
+    return
+  }
+  ctx._memoryPressure = entry
+  watched.add(entry)
+  if (!timer) {
+    timer = setInterval(check, INTERVAL)
+    timer.unref()
+  }
+}
+
+function unwatchMemoryPressure (ctx) {
+  if (ctx._memoryPressure) {
+    watched.delete(ctx._memoryPressure)
+    ctx._memoryPressure = null
+  }
+}
+
+module.exports = { watchMemoryPressure, unwatchMemoryPressure }
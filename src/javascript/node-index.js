@@ -1,8 +1,10 @@
 const bits = require('bit-twiddle')
 const { WebGLContextAttributes } = require('./webgl-context-attributes')
-const { WebGLRenderingContext, WebGL2RenderingContext, wrapContext } = require('./webgl-rendering-context')
-const { WebGLTextureUnit } = require('./webgl-texture-unit')
-const { WebGLVertexArrayObjectState, WebGLVertexArrayGlobalState } = require('./webgl-vertex-attribute')
+const { WebGLRenderingContext, WebGL2RenderingContext, wrapContext, unwrapContext } = require('./webgl-rendering-context')
+const { WebGLShareGroup } = require('./webgl-share-group')
+const { TextureMemoryBudget } = require('./texture-memory-budget')
+const { watchMemoryPressure } = require('./memory-pressure')
+const { NativeWebGL } = require('./native-gl')
 
 let CONTEXT_COUNTER = 0
 
@@ -13,6 +15,59 @@ function flag (options, name, dflt) {
   return !!options[name]
 }
 
+function byteLimit (options, name) {
+  if (!options || !(typeof options === 'object') || !(name in options)) {
+    return Infinity
+  }
+  const limit = +options[name]
+  return limit >= 0 ? limit : Infinity
+}
+
+const DEFAULT_PROGRAM_CACHE_BYTES = 128 * 1024 * 1024
+const DEFAULT_PROGRAM_CACHE_MEMORY_BYTES = 32 * 1024 * 1024
+
+function programCacheOptions (options) {
+  const cache = options && typeof options === 'object' ? options.programCache : undefined
+  if (!cache) {
+    return ['', 0, 0]
+  }
+  if (typeof cache !== 'object') {
+    return ['', 0, DEFAULT_PROGRAM_CACHE_MEMORY_BYTES]
+  }
+  const dir = typeof cache.dir === 'string' ? cache.dir : ''
+  const maxBytes = +cache.maxBytes
+  const memoryBytes = 'memoryBytes' in cache ? +cache.memoryBytes : DEFAULT_PROGRAM_CACHE_MEMORY_BYTES
+  return [
+    dir,
+    maxBytes > 0 ? maxBytes : DEFAULT_PROGRAM_CACHE_BYTES,
+    memoryBytes >= 0 ? memoryBytes : DEFAULT_PROGRAM_CACHE_MEMORY_BYTES
+  ]
+}
+
+function warmProgramManifest (options) {
+  const manifest = options && typeof options === 'object' ? options.warmPrograms : null
+  if (!manifest) {
+    return []
+  }
+  if (!Array.isArray(manifest) || !manifest.every((entry) => entry && typeof entry === 'object' &&
+      'id' in entry && typeof entry.vertex === 'string' && typeof entry.fragment === 'string')) {
+    throw new TypeError('warmPrograms entries need an id, a vertex and a fragment shader')
+  }
+  return manifest
+}
+
+function shareContext (options, webgl2) {
+  const other = options && typeof options === 'object' ? options.shareWith : null
+  if (other === undefined || other === null) {
+    return null
+  }
+  const ctx = unwrapContext(other)
+  if (!ctx || ctx._isWebGL2() !== webgl2) {
+    throw new TypeError('shareWith must be a context of the same WebGL version')
+  }
+  return ctx
+}
+
 function createContext (width, height, options) {
   width = width | 0
   height = height | 0
@@ -36,8 +91,14 @@ function createContext (width, height, options) {
     contextAttributes.premultipliedAlpha && contextAttributes.alpha
 
   const WebGLContext = contextAttributes.createWebGL2Context ? WebGL2RenderingContext : WebGLRenderingContext
+  const [programCacheDir, programCacheMaxBytes, programCacheMemoryBytes] = programCacheOptions(options)
+  const warmPrograms = warmProgramManifest(options)
+  const share = shareContext(options, contextAttributes.createWebGL2Context)
   let ctx
   try {
+    if (share) {
+      share._unpromoteTextures()
+    }
     ctx = new WebGLContext(
       1,
       1,
@@ -49,7 +110,13 @@ function createContext (width, height, options) {
       contextAttributes.preserveDrawingBuffer,
       contextAttributes.preferLowPowerToHighPerformance,
       contextAttributes.failIfMajorPerformanceCaveat,
-      contextAttributes.createWebGL2Context)
+      contextAttributes.createWebGL2Context,
+      flag(options, 'promoteTextureStorage', false),
+      programCacheDir,
+      programCacheMaxBytes,
+      programCacheMemoryBytes,
+      share,
+      byteLimit(options, 'memoryLimit'))
   } catch (e) {}
   if (!ctx) {
     return null
@@ -63,41 +130,21 @@ function createContext (width, height, options) {
   ctx._contextAttributes = contextAttributes
 
   ctx._extensions = {}
-  ctx._programs = {}
-  ctx._shaders = {}
-  ctx._buffers = {}
-  ctx._textures = {}
   ctx._framebuffers = {}
-  ctx._renderbuffers = {}
-
-  ctx._activeProgram = null
-  ctx._activeFramebuffers = { read: null, draw: null }
-  ctx._activeRenderbuffer = null
-  ctx._checkStencil = false
-  ctx._stencilState = true
-
-  if (contextAttributes.createWebGL2Context) {
-    ctx._vaos = {}
-    ctx._activeVertexArrayObject = null
-  }
 
-  // Initialize texture units
-  const numTextures = ctx.getParameter(ctx.MAX_COMBINED_TEXTURE_IMAGE_UNITS)
-  ctx._textureUnits = new Array(numTextures)
-  for (let i = 0; i < numTextures; ++i) {
-    ctx._textureUnits[i] = new WebGLTextureUnit(ctx, i)
-  }
-  ctx._activeTextureUnit = 0
-  ctx.activeTexture(ctx.TEXTURE0)
-
-  ctx._errorStack = []
+  // Programs linked with linkProgramAsync that are still being polled
+  ctx._pendingLinks = []
+  ctx._linkPolls = 0
+  ctx._linkPollScheduled = false
 
-  // Vertex array attributes that are in vertex array objects.
-  ctx._defaultVertexObjectState = new WebGLVertexArrayObjectState(ctx)
-  ctx._vertexObjectState = ctx._defaultVertexObjectState
+  // Buffers, textures, renderbuffers, shaders and programs are looked up in
+  // the share group
+  const shareGroup = share
+    ? share._shareGroup
+    : new WebGLShareGroup(flag(options, 'reclaimObjects', false))
+  shareGroup.join(ctx)
 
-  // Vertex array attibures that are not in vertex array objects.
-  ctx._vertexGlobalState = new WebGLVertexArrayGlobalState(ctx)
+  ctx._initState()
 
   // Store limits
   ctx._maxTextureSize = ctx.getParameter(ctx.MAX_TEXTURE_SIZE)
@@ -105,12 +152,10 @@ function createContext (width, height, options) {
   ctx._maxCubeMapSize = ctx.getParameter(ctx.MAX_CUBE_MAP_TEXTURE_SIZE)
   ctx._maxCubeMapLevel = bits.log2(bits.nextPow2(ctx._maxCubeMapSize))
 
-  // Unpack alignment
-  ctx._unpackAlignment = 4
-  ctx._packAlignment = 4
+  ctx._textureBudget = new TextureMemoryBudget(ctx, byteLimit(options, 'memoryBudget'))
 
-  // Allocate framebuffer
-  ctx._allocateDrawingBuffer(width, height)
+  // Allocated on first use
+  ctx._createDrawingBuffer(flag(options, 'drawingBuffer', true))
 
   const attrib0Buffer = ctx.createBuffer()
   ctx._attrib0Buffer = attrib0Buffer
@@ -125,13 +170,27 @@ function createContext (width, height, options) {
   ctx.viewport(0, 0, width, height)
   ctx.scissor(0, 0, width, height)
 
-  // Clear buffers
+  // Clear values. The drawing buffer itself starts out cleared, as ANGLE
+  // initializes new storage.
   ctx.clearDepth(1)
   ctx.clearColor(0, 0, 0, 0)
   ctx.clearStencil(0)
-  ctx.clear(ctx.COLOR_BUFFER_BIT | ctx.DEPTH_BUFFER_BIT | ctx.STENCIL_BUFFER_BIT)
+
+  // Start compiling the programs the application will ask for first
+  ctx._warmUpPrograms(warmPrograms)
+
+  if (options && typeof options === 'object') {
+    watchMemoryPressure(ctx, options.memoryPressure)
+  }
 
   return wrapContext(ctx)
 }
 
+// Drops the program caches that every context of the process shares from
+// memory. Entries in a programCache directory stay.
+function trimProgramCache () {
+  return NativeWebGL.trimProgramCache()
+}
+
 module.exports = createContext
+module.exports.trimProgramCache = trimProgramCache
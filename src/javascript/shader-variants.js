@@ -0,0 +1,170 @@
+// Feature toggles can be switched on, or given a value that is pasted into
+// the #define.
+function defineValue (value) {
+  if (value === true) {
+    return ''
+  }
+  if (typeof value === 'number' && isFinite(value)) {
+    return String(value)
+  }
+  if (typeof value === 'string' && /^[\w.+\-() ]*$/.test(value)) {
+    return value
+  }
+  return null
+}
+
+// Most variants kept per context before the least recently used are deleted
+const MAX_VARIANTS = 256
+
+// Only whitespace and comments may come before the #version directive
+const VERSION_DIRECTIVE = /^(?:\s|\/\/[^\n]*|\/\*[\s\S]*?\*\/)*#version[^\n]*(?:\n|$)/
+
+// Inserts the defines after the #version directive, which has to come first.
+function specialize (source, defines) {
+  if (!defines) {
+    return source
+  }
+  const version = VERSION_DIRECTIVE.exec(source)
+  if (!version) {
+    return defines + source
+  }
+  const head = version[0].endsWith('\n') ? version[0] : version[0] + '\n'
+  return head + defines + source.slice(version[0].length)
+}
+
+// Programs built from a registered template, one per set of defines. The
+// cache is keyed by the defines that are switched on, sorted by name, so the
+// order they were passed in and toggles that are off don't matter. Once more
+// than MAX_VARIANTS have been built the least recently used are deleted.
+class ShaderVariants {
+  constructor (ctx) {
+    this._ctx = ctx
+    this._templates = new Map()
+    // Every cached variant, least recently used first
+    this._recent = new Set()
+  }
+
+  register (id, template) {
+    if (!template || typeof template !== 'object' ||
+      typeof template.vertex !== 'string' || typeof template.fragment !== 'string') {
+      throw new TypeError('registerShaderTemplate(id, { vertex, fragment, attributes, features })')
+    }
+    const features = Array.isArray(template.features) ? template.features.map(String) : []
+    for (const name of features) {
+      if (!/^[A-Za-z_]\w*$/.test(name)) {
+        throw new TypeError('invalid feature name ' + JSON.stringify(name))
+      }
+    }
+
+    const previous = this._templates.get(id)
+    if (previous) {
+      for (const variant of previous.variants.values()) {
+        this._evict(variant)
+      }
+    }
+    this._templates.set(id, {
+      vertex: template.vertex,
+      fragment: template.fragment,
+      attributes: template.attributes || {},
+      features: new Set(features),
+      variants: new Map()
+    })
+  }
+
+  // Returns the key and #define block for a set of toggles, or throws if
+  // one of them isn't a feature of the template.
+  _normalize (template, defines) {
+    const names = Object.keys(defines || {}).sort()
+    let key = ''
+    let block = ''
+    for (const name of names) {
+      if (!template.features.has(name)) {
+        throw new TypeError('unknown shader feature ' + name)
+      }
+      const raw = defines[name]
+      if (raw === false || raw === undefined || raw === null) {
+        continue
+      }
+      const value = defineValue(raw)
+      if (value === null) {
+        throw new TypeError('invalid value for shader feature ' + name)
+      }
+      key += name + '=' + value + ';'
+      block += '#define ' + name + (value ? ' ' + value : '') + '\n'
+    }
+    return { key, block }
+  }
+
+  _lookup (id, defines) {
+    const template = this._templates.get(id)
+    if (!template) {
+      return null
+    }
+    const { key, block } = this._normalize(template, defines)
+    const ctx = this._ctx
+    let variant = template.variants.get(key)
+    if (variant && ctx._programs[variant.program._ | 0] === variant.program) {
+      this._recent.delete(variant)
+      this._recent.add(variant)
+    } else {
+      // Not built yet, or deleted by the application since
+      if (variant) {
+        this._recent.delete(variant)
+      }
+      const program = ctx._buildProgram(
+        specialize(template.vertex, block),
+        specialize(template.fragment, block),
+        template.attributes)
+      // Only rejects if the context is destroyed first
+      const ready = ctx.linkProgramAsync(program).catch(() => false)
+      variant = { program, ready, template, key }
+      template.variants.set(key, variant)
+      this._recent.add(variant)
+      this._trim(variant)
+    }
+    return variant
+  }
+
+  // Deletes the least recently used variants over the limit, except the one
+  // being handed out and the one in use.
+  _trim (keep) {
+    let excess = this._recent.size - MAX_VARIANTS
+    for (const variant of this._recent) {
+      if (excess <= 0) {
+        break
+      }
+      if (variant !== keep && variant.program !== this._ctx._activeProgram) {
+        this._evict(variant)
+        excess -= 1
+      }
+    }
+  }
+
+  _evict (variant) {
+    this._recent.delete(variant)
+    variant.template.variants.delete(variant.key)
+    const ctx = this._ctx
+    if (ctx._programs[variant.program._ | 0] === variant.program) {
+      ctx.deleteProgram(variant.program)
+    }
+  }
+
+  get (id, defines) {
+    const variant = this._lookup(id, defines)
+    if (!variant) {
+      return null
+    }
+    this._ctx._resolveLink(variant.program)
+    return variant.program
+  }
+
+  getAsync (id, defines) {
+    const variant = this._lookup(id, defines)
+    if (!variant) {
+      return Promise.resolve(null)
+    }
+    return variant.ready.then(() => variant.program)
+  }
+}
+
+module.exports = { ShaderVariants, MAX_VARIANTS }
@@ -0,0 +1,298 @@
+const fs = require('fs')
+const zlib = require('zlib')
+const { gl } = require('./native-gl')
+const { isBufferSource } = require('./utils')
+
+const DECOMPRESSORS = {
+  gzip: zlib.gunzipSync,
+  deflate: zlib.inflateSync,
+  brotli: zlib.brotliDecompressSync
+}
+
+function mipLevelCount (width, height) {
+  let size = Math.max(width, height)
+  let levels = 1
+  while (size > 1) {
+    size >>= 1
+    ++levels
+  }
+  return levels
+}
+
+function checkTextureSource (source) {
+  if (source === null || source === undefined) {
+    return true
+  }
+  if (typeof source !== 'object') {
+    return false
+  }
+  if (source.compression !== undefined && !(source.compression in DECOMPRESSORS)) {
+    return false
+  }
+  return isBufferSource(source.data) ||
+    typeof source.path === 'string' ||
+    typeof source.load === 'function'
+}
+
+// Reads the pixels of level 0 back from where the application keeps them: an
+// in-memory (possibly memory mapped) buffer, a file or a loader callback, any
+// of them optionally compressed.
+function loadTextureSource (source) {
+  let data
+  if (typeof source.load === 'function') {
+    data = source.load()
+  } else if (typeof source.path === 'string') {
+    data = fs.readFileSync(source.path)
+    if (source.offset !== undefined || source.length !== undefined) {
+      const offset = source.offset | 0
+      const end = source.length === undefined ? data.length : offset + (source.length | 0)
+      data = data.subarray(offset, end)
+    }
+  } else {
+    data = source.data
+  }
+  if (source.compression !== undefined) {
+    data = DECOMPRESSORS[source.compression](data)
+  }
+  if (!isBufferSource(data)) {
+    throw new TypeError('Texture source did not produce an ArrayBuffer or ArrayBufferView')
+  }
+  return data
+}
+
+// Tracks how much memory the TEXTURE_2D textures of a context use and keeps it
+// under a budget by releasing the storage of textures that the application
+// marked as evictable, least recently bound first. Evicted textures keep their
+// name and parameters and are uploaded again from their source the next time
+// they are bound.
+class TextureMemoryBudget {
+  constructor (ctx, budget) {
+    this._ctx = ctx
+    this._budget = budget
+    this._residentBytes = 0
+
+    // Evictable textures, least recently bound first
+    this._evictable = new Set()
+
+    this._evictions = 0
+    this._restores = 0
+    this._evictedBytes = 0
+    this._restoredBytes = 0
+  }
+
+  setSize (texture, byteSize) {
+    if (!texture._evicted) {
+      this._residentBytes += byteSize - texture._byteSize
+    }
+    texture._byteSize = byteSize
+    if (texture._reclaim) {
+      texture._reclaim.bytes = byteSize
+    }
+  }
+
+  // Stops counting a texture that was reclaimed after its wrapper went away.
+  // Evictable textures are never reclaimed, so it was resident.
+  release (byteSize) {
+    this._residentBytes -= byteSize
+  }
+
+  setEvictable (texture, source) {
+    if (source) {
+      texture._evictSource = source
+      this._evictable.delete(texture)
+      this._evictable.add(texture)
+      this.enforce()
+    } else {
+      this.pin(texture)
+    }
+  }
+
+  // Stops evicting a texture, for example because its contents no longer match
+  // its source.
+  pin (texture) {
+    if (texture._evicted) {
+      this.restore(texture)
+    }
+    texture._evictSource = null
+    this._evictable.delete(texture)
+  }
+
+  forget (texture) {
+    this._evictable.delete(texture)
+    if (texture._evicted) {
+      texture._evicted = false
+      texture._byteSize = 0
+    } else {
+      this.setSize(texture, 0)
+    }
+  }
+
+  // Takes over a texture from the budget of another context in the same
+  // share group. It counts as just bound for the eviction order.
+  adopt (texture, budget) {
+    if (!texture._evicted) {
+      budget._residentBytes -= texture._byteSize
+      this._residentBytes += texture._byteSize
+    }
+    if (budget._evictable.delete(texture)) {
+      this._evictable.add(texture)
+    }
+    this.enforce()
+  }
+
+  touch (texture) {
+    if (this._evictable.delete(texture)) {
+      this._evictable.add(texture)
+    }
+  }
+
+  enforce () {
+    if (this._residentBytes <= this._budget) {
+      return
+    }
+    for (const texture of this._evictable) {
+      if (this._residentBytes <= this._budget) {
+        break
+      }
+      if (!texture._evicted && !this._isBound(texture)) {
+        this.evict(texture)
+      }
+    }
+  }
+
+  evictAll () {
+    for (const texture of this._evictable) {
+      if (!texture._evicted && !this._isBound(texture)) {
+        this.evict(texture)
+      }
+    }
+  }
+
+  // Textures bound or attached to a framebuffer in any context of the share
+  // group are in use
+  _isBound (texture) {
+    for (const ctx of this._ctx._shareGroup._contexts) {
+      const units = ctx._textureUnits
+      for (let i = 0; i < units.length; ++i) {
+        if (units[i]._bind2D === texture) {
+          return true
+        }
+      }
+      for (const id in ctx._framebuffers) {
+        const attachments = ctx._framebuffers[id]._attachments
+        for (const attachment in attachments) {
+          if (attachments[attachment] === texture) {
+            return true
+          }
+        }
+      }
+    }
+    return false
+  }
+
+  evict (texture) {
+    const ctx = this._ctx
+    const { internalFormat, width, height, format, type } = texture._level0
+    const levels = texture._mipmapped ? mipLevelCount(width, height) : 1
+    const active = ctx._getActiveTexture(gl.TEXTURE_2D)
+
+    ctx._saveError()
+    gl.bindTexture.call(ctx, gl.TEXTURE_2D, texture._ | 0)
+    for (let level = 0; level < levels; ++level) {
+      const replacement = gl.texImage2D.call(
+        ctx, gl.TEXTURE_2D, level, internalFormat, 0, 0, 0, format, type, null)
+      if (replacement) {
+        ctx._shareGroup.rename(ctx._textures, texture, replacement)
+      }
+    }
+    gl.bindTexture.call(ctx, gl.TEXTURE_2D, active ? active._ | 0 : 0)
+    const error = ctx.getError()
+    ctx._restoreError(ctx.NO_ERROR)
+
+    if (error !== gl.NO_ERROR) {
+      // Immutable textures can't be released
+      texture._evictSource = null
+      this._evictable.delete(texture)
+      return false
+    }
+
+    texture._evicted = true
+    this._residentBytes -= texture._byteSize
+    this._evictions += 1
+    this._evictedBytes += texture._byteSize
+    return true
+  }
+
+  // Uploads an evicted texture again. The texture must be bound to TEXTURE_2D
+  // on the active texture unit.
+  restore (texture) {
+    const ctx = this._ctx
+    const level0 = texture._level0
+    const pixels = loadTextureSource(texture._evictSource)
+    const active = ctx._getActiveTexture(gl.TEXTURE_2D)
+
+    ctx._saveError()
+    gl.bindTexture.call(ctx, gl.TEXTURE_2D, texture._ | 0)
+    gl.pixelStorei.call(ctx, gl.UNPACK_FLIP_Y_WEBGL, level0.flipY)
+    gl.pixelStorei.call(ctx, gl.UNPACK_PREMULTIPLY_ALPHA_WEBGL, level0.premultiplyAlpha)
+    gl.pixelStorei.call(ctx, gl.UNPACK_ALIGNMENT, level0.alignment)
+    const replacement = gl.texImage2D.call(
+      ctx,
+      gl.TEXTURE_2D,
+      0,
+      level0.internalFormat,
+      level0.width,
+      level0.height,
+      0,
+      level0.format,
+      level0.type,
+      pixels)
+    if (replacement) {
+      ctx._shareGroup.rename(ctx._textures, texture, replacement)
+    }
+    if (texture._mipmapped) {
+      gl.generateMipmap.call(ctx, gl.TEXTURE_2D)
+    }
+    gl.pixelStorei.call(ctx, gl.UNPACK_FLIP_Y_WEBGL, ctx._unpackFlipY)
+    gl.pixelStorei.call(ctx, gl.UNPACK_PREMULTIPLY_ALPHA_WEBGL, ctx._unpackPremultiplyAlpha)
+    gl.pixelStorei.call(ctx, gl.UNPACK_ALIGNMENT, ctx._unpackAlignment)
+    gl.bindTexture.call(ctx, gl.TEXTURE_2D, active ? active._ | 0 : 0)
+    const error = ctx.getError()
+    ctx._restoreError(error)
+
+    texture._evicted = false
+    if (error !== gl.NO_ERROR) {
+      // The application gets the error, and the texture stays empty rather
+      // than being evicted and restored again
+      texture._evictSource = null
+      this._evictable.delete(texture)
+      texture._byteSize = 0
+      return
+    }
+    this._residentBytes += texture._byteSize
+    this._restores += 1
+    this._restoredBytes += texture._byteSize
+    this.enforce()
+  }
+
+  getStats () {
+    let evictedTextures = 0
+    for (const texture of this._evictable) {
+      if (texture._evicted) {
+        ++evictedTextures
+      }
+    }
+    return {
+      budget: this._budget,
+      residentBytes: this._residentBytes,
+      evictableTextures: this._evictable.size,
+      evictedTextures,
+      evictions: this._evictions,
+      restores: this._restores,
+      evictedBytes: this._evictedBytes,
+      restoredBytes: this._restoredBytes
+    }
+  }
+}
+
+module.exports = { TextureMemoryBudget, checkTextureSource, mipLevelCount }
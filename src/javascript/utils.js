@@ -1,4 +1,4 @@
-const { gl } = require('./native-gl')
+const { gl, NativeWebGL } = require('./native-gl')
 
 const { WebGLUniformLocation } = require('./webgl-uniform-location')
 
@@ -44,11 +44,9 @@ function isTypedArray (data) {
     data instanceof Float64Array
 }
 
-// Don't allow: ", $, `, @, \, ', \0
+// Don't allow: ", $, `, @, \, ', \0 outside of comments
 function isValidString (str) {
-  // Remove comments first
-  const c = str.replace(/(?:\/\*(?:[\s\S]*?)\*\/)|(?:([\s;])+\/\/(?:.*)$)/gm, '')
-  return !(/["$`@\\'\0]/.test(c))
+  return NativeWebGL.validateShaderSource(str)
 }
 
 function vertexCount (primitive, count) {
@@ -159,35 +157,69 @@ function extractImageData (pixels) {
   return null
 }
 
-function formatSize (internalFormat) {
-  switch (internalFormat) {
-    case gl.ALPHA:
-    case gl.LUMINANCE:
-      return 1
-    case gl.LUMINANCE_ALPHA:
-      return 2
-    case gl.RGB:
-      return 3
-    case gl.RGBA:
-      return 4
-  }
-  return 0
+// Bytes per pixel of a format/type pair, from the native pixel format table.
+// Returns 0 for pairs WebGL does not accept.
+function pixelSize (format, type) {
+  return NativeWebGL.pixelFormatSize(format | 0, type | 0)
+}
+
+// ArrayBuffer views (including DataView and Buffer), ArrayBuffers and
+// SharedArrayBuffers are passed to the native code as is, which reads them in
+// place without copying
+function isBufferSource (data) {
+  return ArrayBuffer.isView(data) ||
+    data instanceof ArrayBuffer ||
+    data instanceof SharedArrayBuffer
 }
 
 function convertPixels (pixels) {
-  if (typeof pixels === 'object' && pixels !== null) {
-    if (pixels instanceof ArrayBuffer) {
-      return new Uint8Array(pixels)
-    } else if (pixels instanceof Uint8Array ||
-      pixels instanceof Uint16Array ||
-      pixels instanceof Uint8ClampedArray ||
-      pixels instanceof Float32Array) {
-      return unpackTypedArray(pixels)
-    } else if (pixels instanceof Buffer) {
-      return new Uint8Array(pixels)
-    }
+  return isBufferSource(pixels) ? pixels : null
+}
+
+// WebGL 2 and extension types, which the shared prototype doesn't define
+const HALF_FLOAT = 0x140B
+const HALF_FLOAT_OES = 0x8D61
+const UNSIGNED_INT_2_10_10_10_REV = 0x8368
+const UNSIGNED_INT_10F_11F_11F_REV = 0x8C3B
+const UNSIGNED_INT_5_9_9_9_REV = 0x8C3E
+const UNSIGNED_INT_24_8 = 0x84FA
+const FLOAT_32_UNSIGNED_INT_24_8_REV = 0x8DAD
+
+// WebGL only takes pixels from a view whose element type matches type, for
+// example a Float32Array for FLOAT. Raw ArrayBuffers are read as bytes, and
+// types WebGL doesn't know are left for GL to reject.
+function checkPixelsType (pixels, type) {
+  if (!ArrayBuffer.isView(pixels)) {
+    return true
   }
-  return null
+  switch (type) {
+    case gl.UNSIGNED_BYTE:
+      return pixels instanceof Uint8Array || pixels instanceof Uint8ClampedArray
+    case gl.BYTE:
+      return pixels instanceof Int8Array
+    case gl.UNSIGNED_SHORT:
+    case gl.UNSIGNED_SHORT_5_6_5:
+    case gl.UNSIGNED_SHORT_4_4_4_4:
+    case gl.UNSIGNED_SHORT_5_5_5_1:
+    case HALF_FLOAT:
+    case HALF_FLOAT_OES:
+      return pixels instanceof Uint16Array
+    case gl.SHORT:
+      return pixels instanceof Int16Array
+    case gl.UNSIGNED_INT:
+    case UNSIGNED_INT_2_10_10_10_REV:
+    case UNSIGNED_INT_10F_11F_11F_REV:
+    case UNSIGNED_INT_5_9_9_9_REV:
+    case UNSIGNED_INT_24_8:
+      return pixels instanceof Uint32Array
+    case gl.INT:
+      return pixels instanceof Int32Array
+    case gl.FLOAT:
+      return pixels instanceof Float32Array
+    case FLOAT_32_UNSIGNED_INT_24_8_REV:
+      return false
+  }
+  return true
 }
 
 function checkFormat (format) {
@@ -212,15 +244,17 @@ module.exports = {
   bindPublics,
   checkObject,
   isTypedArray,
+  isBufferSource,
   isValidString,
   vertexCount,
   typeSize,
   uniformTypeSize,
   unpackTypedArray,
   extractImageData,
-  formatSize,
+  pixelSize,
   checkFormat,
   checkUniform,
   convertPixels,
+  checkPixelsType,
   validCubeTarget
 }
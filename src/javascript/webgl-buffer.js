@@ -5,13 +5,13 @@ class WebGLBuffer extends Linkable {
   constructor (_, ctx) {
     super(_)
     this._ctx = ctx
+    this._reclaim = null
     this._size = 0
-    this._elements = new Uint8Array(0)
   }
 
   _performDelete () {
     const ctx = this._ctx
-    delete ctx._buffers[this._ | 0]
+    ctx._shareGroup.remove(ctx._buffers, this)
     gl.deleteBuffer.call(ctx, this._ | 0)
   }
 }
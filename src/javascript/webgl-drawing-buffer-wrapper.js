@@ -1,8 +1,13 @@
 class WebGLDrawingBufferWrapper {
-  constructor (framebuffer, color, depthStencil) {
+  constructor (framebuffer, color, depthStencil, enabled) {
     this._framebuffer = framebuffer
     this._color = color
     this._depthStencil = depthStencil
+
+    // Storage is only allocated once the default framebuffer is used, and
+    // never for contexts created with drawingBuffer: false
+    this._enabled = enabled
+    this._allocated = false
   }
 }
 
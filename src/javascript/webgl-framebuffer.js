@@ -10,6 +10,9 @@ class WebGLFramebuffer extends Linkable {
     this._width = 0
     this._height = 0
     this._status = null
+
+    // The texture or renderbuffer at each attachment point
+    this._attachments = {}
   }
 
   _performDelete () {
@@ -5,6 +5,7 @@ class WebGLRenderbuffer extends Linkable {
   constructor (_, ctx) {
     super(_)
     this._ctx = ctx
+    this._reclaim = null
     this._binding = 0
     this._width = 0
     this._height = 0
@@ -13,7 +14,7 @@ class WebGLRenderbuffer extends Linkable {
 
   _performDelete () {
     const ctx = this._ctx
-    delete ctx._renderbuffers[this._ | 0]
+    ctx._shareGroup.remove(ctx._renderbuffers, this)
     gl.deleteRenderbuffer.call(ctx, this._ | 0)
   }
 }
@@ -20,11 +20,15 @@ const {
   typeSize,
   uniformTypeSize,
   extractImageData,
-  isTypedArray,
-  unpackTypedArray,
+  isBufferSource,
   convertPixels,
+  checkPixelsType,
+  pixelSize,
   validCubeTarget
 } = require('./utils')
+const { checkTextureSource, TextureMemoryBudget } = require('./texture-memory-budget')
+const { ShaderVariants } = require('./shader-variants')
+const { unwatchMemoryPressure } = require('./memory-pressure')
 
 const { WebGLActiveInfo } = require('./webgl-active-info')
 const { WebGLFramebuffer } = require('./webgl-framebuffer')
@@ -34,24 +38,42 @@ const { WebGLProgram } = require('./webgl-program')
 const { WebGLRenderbuffer } = require('./webgl-renderbuffer')
 const { WebGLShader } = require('./webgl-shader')
 const { WebGLShaderPrecisionFormat } = require('./webgl-shader-precision-format')
+const { WebGLShareGroup, deref } = require('./webgl-share-group')
 const { WebGLTexture } = require('./webgl-texture')
+const { WebGLTextureUnit } = require('./webgl-texture-unit')
 const { WebGLUniformLocation } = require('./webgl-uniform-location')
 const { WebGLVertexArrayObject } = require('./webgl-vertex-array-object')
+const { WebGLVertexArrayObjectState, WebGLVertexArrayGlobalState } = require('./webgl-vertex-attribute')
 const { getEXTColorBufferFloat } = require('./extensions/ext-color-buffer-float')
+const { getKHRParallelShaderCompile } = require('./extensions/khr-parallel-shader-compile')
 
 // These are defined by the WebGL spec
 const MAX_UNIFORM_LENGTH = 256
 const MAX_ATTRIBUTE_LENGTH = 256
+const COMPLETION_STATUS_KHR = 0x91B1
 
-const DEFAULT_ATTACHMENTS = [
-  gl.COLOR_ATTACHMENT0,
-  gl.DEPTH_ATTACHMENT,
-  gl.STENCIL_ATTACHMENT,
-  gl.DEPTH_STENCIL_ATTACHMENT
-]
+// Pending links are polled on the next few turns of the event loop, then
+// with timers that back off up to the longest delay, in milliseconds
+const LINK_POLL_IMMEDIATE = 4
+const LINK_POLL_MAX_DELAY = 16
 
 const DEFAULT_COLOR_ATTACHMENTS = [gl.COLOR_ATTACHMENT0]
 
+// Parameters that describe the framebuffer bound to the context, which needs
+// the drawing buffer allocated when it is the default one
+const DRAWING_BUFFER_PARAMETERS = new Set([
+  gl.RED_BITS,
+  gl.GREEN_BITS,
+  gl.BLUE_BITS,
+  gl.ALPHA_BITS,
+  gl.DEPTH_BITS,
+  gl.STENCIL_BITS,
+  gl.SAMPLES,
+  gl.SAMPLE_BUFFERS,
+  gl.IMPLEMENTATION_COLOR_READ_FORMAT,
+  gl.IMPLEMENTATION_COLOR_READ_TYPE
+])
+
 const availableExtensions = {
   angle_instanced_arrays: getANGLEInstancedArrays,
   oes_element_index_uint: getOESElementIndexUint,
@@ -65,7 +87,8 @@ const availableExtensions = {
   ext_blend_minmax: getEXTBlendMinMax,
   ext_texture_filter_anisotropic: getEXTTextureFilterAnisotropic,
   ext_shader_texture_lod: getEXTShaderTextureLod,
-  ext_color_buffer_float: getEXTColorBufferFloat
+  ext_color_buffer_float: getEXTColorBufferFloat,
+  khr_parallel_shader_compile: getKHRParallelShaderCompile
 }
 
 const privateMethods = [
@@ -74,6 +97,13 @@ const privateMethods = [
   'destroy'
 ]
 
+// The context behind each wrapper handed out to applications
+const wrappedContexts = new WeakMap()
+
+function unwrapContext (wrapper) {
+  return wrappedContexts.get(wrapper) || null
+}
+
 function wrapContext (ctx) {
   const isWebGL2 = ctx.constructor.name === 'WebGL2RenderingContext'
   const wrapper = isWebGL2 ? new WebGL2RenderingContext() : new WebGLRenderingContext()
@@ -98,6 +128,7 @@ function wrapContext (ctx) {
     }
   })
 
+  wrappedContexts.set(wrapper, ctx)
   return wrapper
 }
 
@@ -107,7 +138,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!(location instanceof WebGLUniformLocation)) {
       this.setError(this.INVALID_VALUE)
       return false
-    } else if (location._program._ctx !== this ||
+    } else if (!this._checkOwns(location._program) ||
       location._linkCount !== location._program._linkCount) {
       this.setError(this.INVALID_OPERATION)
       return false
@@ -127,9 +158,16 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return true
   }
 
+  // Framebuffers and vertex arrays belong to the context that created them,
+  // other objects to its share group.
   _checkOwns (object) {
-    return typeof object === 'object' &&
-      object._ctx === this
+    if (typeof object !== 'object' || !object._ctx) {
+      return false
+    }
+    if (object instanceof WebGLFramebuffer || object instanceof WebGLVertexArrayObject) {
+      return object._ctx === this
+    }
+    return object._ctx._shareGroup === this._shareGroup
   }
 
   _checkShaderSource (shader) {
@@ -181,49 +219,57 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return true
   }
 
-  _fixupLink (program) {
-    if (!super.getProgramParameter(program._, this.LINK_STATUS)) {
-      program._linkInfoLog = super.getProgramInfoLog(program._)
+  _fixupLink (program, reflection) {
+    if (!reflection.linkStatus) {
+      program._linkInfoLog = reflection.infoLog
       return false
     }
 
-    // Record attribute attributeLocations
-    const numAttribs = this.getProgramParameter(program, this.ACTIVE_ATTRIBUTES)
-    const names = new Array(numAttribs)
-    program._attributes.length = numAttribs
-    for (let i = 0; i < numAttribs; ++i) {
-      names[i] = this.getActiveAttrib(program, i).name
-      program._attributes[i] = this.getAttribLocation(program, names[i]) | 0
+    // Record attribute locations
+    const { attributes, uniforms } = reflection
+    program._attributes.length = attributes.length
+    for (let i = 0; i < attributes.length; ++i) {
+      program._attributes[i] = attributes[i].location | 0
     }
+    program._uniforms = uniforms.map((uniform) => new WebGLActiveInfo(uniform))
+    program._uniformBlocks = reflection.uniformBlocks
 
-    // Check attribute names
-    for (let i = 0; i < names.length; ++i) {
-      if (names[i].length > MAX_ATTRIBUTE_LENGTH) {
-        program._linkInfoLog = 'attribute ' + names[i] + ' is too long'
+    // Check attribute and uniform name lengths
+    for (let i = 0; i < attributes.length; ++i) {
+      if (attributes[i].name.length > MAX_ATTRIBUTE_LENGTH) {
+        program._linkInfoLog = 'attribute ' + attributes[i].name + ' is too long'
         return false
       }
     }
-
-    for (let i = 0; i < numAttribs; ++i) {
-      super.bindAttribLocation(
-        program._ | 0,
-        program._attributes[i],
-        names[i])
-    }
-
-    super.linkProgram(program._ | 0)
-
-    const numUniforms = this.getProgramParameter(program, this.ACTIVE_UNIFORMS)
-    program._uniforms.length = numUniforms
-    for (let i = 0; i < numUniforms; ++i) {
-      program._uniforms[i] = this.getActiveUniform(program, i)
+    for (let i = 0; i < uniforms.length; ++i) {
+      if (uniforms[i].name.length > MAX_UNIFORM_LENGTH) {
+        program._linkInfoLog = 'uniform ' + uniforms[i].name + ' is too long'
+        return false
+      }
     }
 
-    // Check attribute and uniform name lengths
-    for (let i = 0; i < program._uniforms.length; ++i) {
-      if (program._uniforms[i].name.length > MAX_UNIFORM_LENGTH) {
-        program._linkInfoLog = 'uniform ' + program._uniforms[i].name + ' is too long'
-        return false
+    // Index every name getUniformLocation accepts, with array elements
+    // addressable individually
+    for (let i = 0; i < uniforms.length; ++i) {
+      const uniform = uniforms[i]
+      const info = program._uniforms[i]
+      if (uniform.locations) {
+        const baseName = uniform.name.slice(0, -3)
+        for (let j = 0; j < uniform.locations.length; ++j) {
+          program._uniformLocations.set(baseName + '[' + j + ']', {
+            location: uniform.locations[j],
+            info,
+            array: j === 0 ? uniform.locations : null,
+            object: null
+          })
+        }
+      } else {
+        program._uniformLocations.set(uniform.name, {
+          location: uniform.location,
+          info,
+          array: null,
+          object: null
+        })
       }
     }
 
@@ -231,10 +277,48 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return true
   }
 
+  // Compile and link results are only read back when they are needed, so that
+  // ANGLE can finish them on its worker threads in the meantime.
+  _resolveCompile (shader) {
+    if (shader._compilePending) {
+      shader._compilePending = false
+      const prevError = this.getError()
+      shader._compileStatus = !!super.getShaderParameter(
+        shader._ | 0,
+        this.COMPILE_STATUS)
+      shader._compileInfo = super.getShaderInfoLog(shader._ | 0)
+      this.getError()
+      this.setError(prevError)
+    }
+  }
+
+  _resolveLink (program) {
+    if (program._linkPending) {
+      program._linkPending = false
+      const prevError = this.getError()
+      program._linkStatus = this._fixupLink(program, super._reflectProgram(program._ | 0))
+      this.getError()
+      this.setError(prevError)
+    }
+    return program._linkStatus
+  }
+
   _framebufferOk () {
     return true
   }
 
+  // Gives the drawing buffer its storage the first time something draws into,
+  // reads from or queries the default framebuffer, so that contexts that only
+  // render to their own framebuffers never pay for it
+  _ensureDrawingBuffer () {
+    const drawingBuffer = this._drawingBuffer
+    if (!drawingBuffer._allocated && drawingBuffer._enabled &&
+      (this._activeFramebuffers.draw === null || this._activeFramebuffers.read === null)) {
+      drawingBuffer._allocated = true
+      this._resizeDrawingBuffer(this.drawingBufferWidth, this.drawingBufferHeight)
+    }
+  }
+
   _getActiveBuffer (target) {
     if (target === this.ARRAY_BUFFER) {
       return this._vertexGlobalState._arrayBufferBinding
@@ -270,10 +354,6 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
   }
 
-  _getAttachments () {
-    return this._extensions.webgl_draw_buffers ? this._extensions.webgl_draw_buffers._ALL_ATTACHMENTS : DEFAULT_ATTACHMENTS
-  }
-
   _getColorAttachments () {
     return this._extensions.webgl_draw_buffers ? this._extensions.webgl_draw_buffers._ALL_COLOR_ATTACHMENTS : DEFAULT_COLOR_ATTACHMENTS
   }
@@ -312,82 +392,17 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return false
   }
 
+  // Allocates or resizes the drawing buffer in one native call, which keeps
+  // the bindings as they were. Storage is reused when the new size fits in
+  // it, and otherwise replaced along with the color texture.
   _resizeDrawingBuffer (width, height) {
-    const prevFramebuffer = this._activeFramebuffers.draw
-    const prevTexture = this._getActiveTexture(this.TEXTURE_2D)
-    const prevRenderbuffer = this._activeRenderbuffer
-
-    const contextAttributes = this._contextAttributes
-
     const drawingBuffer = this._drawingBuffer
-    super.bindFramebuffer(this.FRAMEBUFFER, drawingBuffer._framebuffer)
-    const attachments = this._getAttachments()
-    // Clear all attachments
-    for (let i = 0; i < attachments.length; ++i) {
-      super.framebufferTexture2D(
-        this.FRAMEBUFFER,
-        attachments[i],
-        this.TEXTURE_2D,
-        0,
-        0)
-    }
-
-    // Update color attachment
-    super.bindTexture(this.TEXTURE_2D, drawingBuffer._color)
-    const colorFormat = contextAttributes.alpha ? this.RGBA : this.RGB
-    super.texImage2D(
-      this.TEXTURE_2D,
-      0,
-      colorFormat,
-      width,
-      height,
-      0,
-      colorFormat,
-      this.UNSIGNED_BYTE,
-      null)
-    super.texParameteri(this.TEXTURE_2D, this.TEXTURE_MIN_FILTER, this.NEAREST)
-    super.texParameteri(this.TEXTURE_2D, this.TEXTURE_MAG_FILTER, this.NEAREST)
-    super.framebufferTexture2D(
-      this.FRAMEBUFFER,
-      this.COLOR_ATTACHMENT0,
-      this.TEXTURE_2D,
+    drawingBuffer._color = super._resizeDrawingBuffer(
+      drawingBuffer._framebuffer,
       drawingBuffer._color,
-      0)
-
-    // Update depth-stencil attachments if needed
-    let storage = 0
-    let attachment = 0
-    if (contextAttributes.depth && contextAttributes.stencil) {
-      storage = this.DEPTH_STENCIL
-      attachment = this.DEPTH_STENCIL_ATTACHMENT
-    } else if (contextAttributes.depth) {
-      storage = 0x81A7
-      attachment = this.DEPTH_ATTACHMENT
-    } else if (contextAttributes.stencil) {
-      storage = this.STENCIL_INDEX8
-      attachment = this.STENCIL_ATTACHMENT
-    }
-
-    if (storage) {
-      super.bindRenderbuffer(
-        this.RENDERBUFFER,
-        drawingBuffer._depthStencil)
-      super.renderbufferStorage(
-        this.RENDERBUFFER,
-        storage,
-        width,
-        height)
-      super.framebufferRenderbuffer(
-        this.FRAMEBUFFER,
-        attachment,
-        this.RENDERBUFFER,
-        drawingBuffer._depthStencil)
-    }
-
-    // Restore previous binding state
-    this.bindFramebuffer(this.FRAMEBUFFER, prevFramebuffer)
-    this.bindTexture(this.TEXTURE_2D, prevTexture)
-    this.bindRenderbuffer(this.RENDERBUFFER, prevRenderbuffer)
+      drawingBuffer._depthStencil,
+      width,
+      height)
   }
 
   _restoreError (lastError) {
@@ -403,6 +418,57 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     this._errorStack.push(this.getError())
   }
 
+  // Promoted texture storage is immutable, so calls that redefine such a
+  // texture move it to a new GL texture, whose name the wrapper takes over
+  _adoptTextureName (target, name) {
+    if (name) {
+      this._shareGroup.rename(this._textures, this._getActiveTexture(target), name)
+    }
+  }
+
+  // Called before another context starts sharing textures with this one,
+  // since only a context that shares them with no other keeps them promoted
+  _unpromoteTextures () {
+    const names = super._unpromoteTextures()
+    for (let i = 0; i < names.length; i += 2) {
+      const texture = deref(this._textures[names[i]])
+      if (texture) {
+        this._shareGroup.rename(this._textures, texture, names[i + 1])
+      }
+    }
+  }
+
+  // Remembers what is attached to the framebuffer bound to target, so that
+  // the texture memory budget never evicts a texture that is rendered to
+  _recordAttachment (target, attachment, object) {
+    const framebuffer = this._getActiveFramebuffer(target)
+    if (attachment === this.DEPTH_STENCIL_ATTACHMENT) {
+      framebuffer._attachments[this.DEPTH_ATTACHMENT] = object
+      framebuffer._attachments[this.STENCIL_ATTACHMENT] = object
+    } else {
+      framebuffer._attachments[attachment] = object
+    }
+  }
+
+  _pinTexture (texture) {
+    if (texture && texture._evictSource) {
+      texture._ctx._textureBudget.pin(texture)
+    }
+  }
+
+  _updateTextureLevel (texture, level, byteSize) {
+    if (level === 0) {
+      texture._levelSize = byteSize
+    } else {
+      texture._mipmapped = true
+      texture._uploadedMipLevels = true
+    }
+    const size = texture._mipmapped ? Math.ceil(texture._levelSize * 4 / 3) : texture._levelSize
+    const budget = texture._ctx._textureBudget
+    budget.setSize(texture, size)
+    budget.enforce()
+  }
+
   _switchActiveProgram (active) {
     if (active) {
       active._refCount -= 1
@@ -714,6 +780,15 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
 
     if (target === this.TEXTURE_2D) {
       activeUnit._bind2D = texture
+      if (texture) {
+        // Shared textures are counted in the budget of the context that
+        // created them
+        const budget = texture._ctx._textureBudget
+        budget.touch(texture)
+        if (texture._evicted) {
+          budget.restore(texture)
+        }
+      }
     } else if (target === this.TEXTURE_CUBE_MAP) {
       activeUnit._bindCube = texture
     } else if (this._isWebGL2() && target === this.TEXTURE_2D_ARRAY) {
@@ -786,7 +861,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     const id = super.createBuffer()
     if (id <= 0) return null
     const webGLBuffer = new WebGLBuffer(id, this)
-    this._buffers[id] = webGLBuffer
+    this._shareGroup.add(this._buffers, webGLBuffer)
     return webGLBuffer
   }
 
@@ -810,7 +885,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     const id = super.createRenderbuffer()
     if (id <= 0) return null
     const webGLRenderbuffer = new WebGLRenderbuffer(id, this)
-    this._renderbuffers[id] = webGLRenderbuffer
+    this._shareGroup.add(this._renderbuffers, webGLRenderbuffer)
     return webGLRenderbuffer
   }
 
@@ -818,7 +893,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     const id = super.createTexture()
     if (id <= 0) return null
     const webGlTexture = new WebGLTexture(id, this)
-    this._textures[id] = webGlTexture
+    this._shareGroup.add(this._textures, webGlTexture)
     return webGlTexture
   }
 
@@ -929,12 +1004,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     if (typeof data === 'object') {
-      let u8Data = null
-      if (isTypedArray(data) || data instanceof DataView) {
-        u8Data = unpackTypedArray(data)
-      } else if (data instanceof ArrayBuffer) {
-        u8Data = new Uint8Array(data)
-      } else {
+      if (!isBufferSource(data)) {
         this.setError(this.INVALID_VALUE)
         return
       }
@@ -942,7 +1012,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       this._saveError()
       super.bufferData(
         target,
-        u8Data,
+        data,
         usage)
       const error = this.getError()
       this._restoreError(error)
@@ -950,10 +1020,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
         return
       }
 
-      active._size = u8Data.length
-      if (target === this.ELEMENT_ARRAY_BUFFER) {
-        active._elements = new Uint8Array(u8Data)
-      }
+      active._size = data.byteLength
     } else if (typeof data === 'number') {
       const size = data | 0
       if (size < 0) {
@@ -973,9 +1040,6 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       }
 
       active._size = size
-      if (target === this.ELEMENT_ARRAY_BUFFER) {
-        active._elements = new Uint8Array(size)
-      }
     } else {
       this.setError(this.INVALID_VALUE)
     }
@@ -1011,32 +1075,24 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       return
     }
 
-    let u8Data = null
-    if (isTypedArray(data) || data instanceof DataView) {
-      u8Data = unpackTypedArray(data)
-    } else if (data instanceof ArrayBuffer) {
-      u8Data = new Uint8Array(data)
-    } else {
+    if (!isBufferSource(data)) {
       this.setError(this.INVALID_VALUE)
       return
     }
 
-    if (offset + u8Data.length > active._size) {
+    if (offset + data.byteLength > active._size) {
       this.setError(this.INVALID_VALUE)
       return
     }
 
-    if (target === this.ELEMENT_ARRAY_BUFFER) {
-      active._elements.set(u8Data, offset)
-    }
-
     super.bufferSubData(
       target,
       offset,
-      u8Data)
+      data)
   }
 
   checkFramebufferStatus (target) {
+    this._ensureDrawingBuffer()
     return super.checkFramebufferStatus(target)
   }
 
@@ -1044,6 +1100,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!this._framebufferOk()) {
       return
     }
+    this._ensureDrawingBuffer()
     return super.clear(mask | 0)
   }
 
@@ -1073,11 +1130,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       const prevError = this.getError()
       super.compileShader(shader._ | 0)
       const error = this.getError()
-      shader._compileStatus = !!super.getShaderParameter(
-        shader._ | 0,
-        this.COMPILE_STATUS)
-      shader._compileInfo = super.getShaderInfoLog(shader._ | 0)
-      this.getError()
+      shader._compilePending = error === this.NO_ERROR
       this.setError(prevError || error)
     }
   }
@@ -1097,8 +1150,9 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     height |= 0
     border |= 0
 
+    this._ensureDrawingBuffer()
     this._saveError()
-    super.copyTexImage2D(
+    const replacement = super.copyTexImage2D(
       target,
       level,
       internalFormat,
@@ -1107,6 +1161,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       width,
       height,
       border)
+    this._adoptTextureName(target, replacement)
     const error = this.getError()
     this._restoreError(error)
 
@@ -1114,6 +1169,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       const texture = this._getTexImage(target)
       texture._format = gl.RGBA
       texture._type = gl.UNSIGNED_BYTE
+      if (target === this.TEXTURE_2D) {
+        this._updateTextureLevel(texture, level, width * height * pixelSize(internalFormat, gl.UNSIGNED_BYTE))
+        this._pinTexture(texture)
+      }
     }
   }
 
@@ -1131,6 +1190,11 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     width |= 0
     height |= 0
 
+    if (target === this.TEXTURE_2D) {
+      this._pinTexture(this._getActiveTexture(target))
+    }
+
+    this._ensureDrawingBuffer()
     super.copyTexSubImage2D(
       target,
       level,
@@ -1363,6 +1427,8 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   }
 
   destroy () {
+    unwatchMemoryPressure(this)
+    this._shareGroup.leave(this)
     super.destroy()
   }
 
@@ -1409,6 +1475,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     first |= 0
     count |= 0
 
+    this._ensureDrawingBuffer()
     return super.drawArrays(mode, first, count)
   }
 
@@ -1418,6 +1485,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     type |= 0
     ioffset |= 0
 
+    this._ensureDrawingBuffer()
     return super.drawElements(mode, count, type, ioffset)
   }
 
@@ -1439,10 +1507,12 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   }
 
   finish () {
+    this._shareGroup.reclaim(this)
     return super.finish()
   }
 
   flush () {
+    this._shareGroup.reclaim(this)
     return super.flush()
   }
 
@@ -1469,7 +1539,13 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       return
     }
 
+    this._saveError()
     super.framebufferRenderbuffer(target, attachment, renderbufferTarget, renderbuffer?._ ?? null)
+    const error = this.getError()
+    this._restoreError(error)
+    if (error === this.NO_ERROR) {
+      this._recordAttachment(target, attachment, renderbuffer)
+    }
   }
 
   framebufferTexture2D (
@@ -1497,7 +1573,18 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       return
     }
 
+    if (texture) {
+      texture._renderTarget = true
+      this._pinTexture(texture)
+    }
+
+    this._saveError()
     super.framebufferTexture2D(target, attachment, textarget, texture?._ ?? null, level)
+    const error = this.getError()
+    this._restoreError(error)
+    if (error === this.NO_ERROR) {
+      this._recordAttachment(target, attachment, texture)
+    }
   }
 
   framebufferTextureLayer (target, attachment, texture, level, layer) {
@@ -1520,7 +1607,13 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       return
     }
 
+    this._saveError()
     super.framebufferTextureLayer(target, attachment, texture?._ ?? null, level, layer)
+    const error = this.getError()
+    this._restoreError(error)
+    if (error === this.NO_ERROR) {
+      this._recordAttachment(target, attachment, texture)
+    }
   }
 
   frontFace (mode) {
@@ -1528,7 +1621,22 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   }
 
   generateMipmap (target) {
-    return super.generateMipmap(target | 0) | 0
+    target |= 0
+
+    this._saveError()
+    super.generateMipmap(target)
+    const error = this.getError()
+    this._restoreError(error)
+
+    if (error === this.NO_ERROR && target === this.TEXTURE_2D) {
+      const texture = this._getActiveTexture(target)
+      texture._mipmapped = true
+      texture._uploadedMipLevels = false
+      const budget = texture._ctx._textureBudget
+      budget.setSize(texture, Math.ceil(texture._levelSize * 4 / 3))
+      budget.enforce()
+    }
+    return 0
   }
 
   getActiveAttrib (program, index) {
@@ -1537,6 +1645,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     } else if (!program) {
       this.setError(this.INVALID_VALUE)
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       const info = super.getActiveAttrib(program._ | 0, index | 0)
       if (info) {
         return new WebGLActiveInfo(info)
@@ -1551,6 +1660,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     } else if (!program) {
       this.setError(this.INVALID_VALUE)
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       const info = super.getActiveUniform(program._ | 0, index | 0)
       if (info) {
         return new WebGLActiveInfo(info)
@@ -1590,12 +1700,16 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!isValidString(name) || name.length > MAX_ATTRIBUTE_LENGTH) {
       this.setError(this.INVALID_VALUE)
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       return super.getAttribLocation(program._ | 0, name + '')
     }
     return -1
   }
 
   getParameter (pname) {
+    if (DRAWING_BUFFER_PARAMETERS.has(pname)) {
+      this._ensureDrawingBuffer()
+    }
     switch (pname) {
       case this.COMPRESSED_TEXTURE_FORMATS:
         return new Uint32Array(0)
@@ -1706,9 +1820,9 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (error === this.NO_ERROR && pname === this.FRAMEBUFFER_ATTACHMENT_OBJECT_NAME) {
       const type = super.getFramebufferAttachmentParameter(target, attachment, this.FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE)
       if (type === this.RENDERBUFFER) {
-        return this._renderbuffers[result]
+        return deref(this._renderbuffers[result])
       } else {
-        return this._textures[result]
+        return deref(this._textures[result])
       }
     }
 
@@ -1720,6 +1834,11 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(program)) {
       throw new TypeError('getProgramParameter(WebGLProgram, GLenum)')
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      if (pname === COMPLETION_STATUS_KHR && this._extensions.khr_parallel_shader_compile) {
+        return !program._linkPending ||
+          !!super.getProgramParameter(program._ | 0, COMPLETION_STATUS_KHR)
+      }
+      this._resolveLink(program)
       switch (pname) {
         case this.DELETE_STATUS:
           return program._pendingDelete
@@ -1734,6 +1853,12 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
         case this.ACTIVE_ATTRIBUTES:
         case this.ACTIVE_UNIFORMS:
           return super.getProgramParameter(program._, pname)
+
+        case this.ACTIVE_UNIFORM_BLOCKS:
+          if (this._isWebGL2()) {
+            return program._uniformBlocks.length
+          }
+          break
       }
       this.setError(this.INVALID_ENUM)
     }
@@ -1744,6 +1869,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(program)) {
       throw new TypeError('getProgramInfoLog(WebGLProgram)')
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       return program._linkInfoLog
     }
     return null
@@ -1786,10 +1912,15 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(shader)) {
       throw new TypeError('getShaderParameter(WebGLShader, GLenum)')
     } else if (this._checkWrapper(shader, WebGLShader)) {
+      if (pname === COMPLETION_STATUS_KHR && this._extensions.khr_parallel_shader_compile) {
+        return !shader._compilePending ||
+          !!super.getShaderParameter(shader._ | 0, COMPLETION_STATUS_KHR)
+      }
       switch (pname) {
         case this.DELETE_STATUS:
           return shader._pendingDelete
         case this.COMPILE_STATUS:
+          this._resolveCompile(shader)
           return shader._compileStatus
         case this.SHADER_TYPE:
           return shader._type
@@ -1803,6 +1934,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(shader)) {
       throw new TypeError('getShaderInfoLog(WebGLShader)')
     } else if (this._checkWrapper(shader, WebGLShader)) {
+      this._resolveCompile(shader)
       return shader._compileInfo
     }
     return null
@@ -1848,6 +1980,32 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return null
   }
 
+  // Compile and link times grouped by source, slowest first, with the live
+  // shaders and programs built from each source
+  getShaderStats () {
+    const stats = super._getShaderStats()
+    const byTime = (a, b) => b.totalMs - a.totalMs
+    const withObjects = (entries, objects, key) => entries.sort(byTime).map((entry) => {
+      const { ids, ...rest } = entry
+      rest[key] = ids.map((id) => objects[id]).filter(Boolean)
+      return rest
+    })
+    return {
+      shaders: withObjects(stats.shaders, this._shaders, 'shaders'),
+      programs: withObjects(stats.programs, this._programs, 'programs'),
+      histograms: stats.histograms
+    }
+  }
+
+  getTextureMemoryStats () {
+    return this._textureBudget.getStats()
+  }
+
+  getMemoryInfo () {
+    const { _framebuffer, _color, _depthStencil } = this._drawingBuffer
+    return super._getMemoryInfo(_framebuffer, _color, _depthStencil)
+  }
+
   getUniform (program, location) {
     if (!checkObject(program) ||
       !checkObject(location)) {
@@ -1858,6 +2016,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     } else if (!location) {
       return null
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       if (!checkUniform(program, location)) {
         this.setError(this.INVALID_OPERATION)
         return null
@@ -1919,63 +2078,19 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     if (this._checkWrapper(program, WebGLProgram)) {
-      const loc = super.getUniformLocation(program._ | 0, name)
-      if (loc >= 0) {
-        let searchName = name
-        if (/\[\d+\]$/.test(name)) {
-          searchName = name.replace(/\[\d+\]$/, '[0]')
-        }
-
-        let info = null
-        for (let i = 0; i < program._uniforms.length; ++i) {
-          const infoItem = program._uniforms[i]
-          if (infoItem.name === searchName) {
-            info = {
-              size: infoItem.size,
-              type: infoItem.type,
-              name: infoItem.name
-            }
-          }
-        }
-        if (!info) {
-          return null
-        }
-
-        const result = new WebGLUniformLocation(
-          loc,
-          program,
-          info)
-
-        // handle array case
-        if (/\[0\]$/.test(name)) {
-          const baseName = name.replace(/\[0\]$/, '')
-          const arrayLocs = []
-
-          // if (offset < 0 || offset >= info.size) {
-          //   return null
-          // }
-
-          this._saveError()
-          for (let i = 0; this.getError() === this.NO_ERROR; ++i) {
-            const xloc = super.getUniformLocation(
-              program._ | 0,
-              baseName + '[' + i + ']')
-            if (this.getError() !== this.NO_ERROR || xloc < 0) {
-              break
-            }
-            arrayLocs.push(xloc)
-          }
-          this._restoreError(this.NO_ERROR)
-
-          result._array = arrayLocs
-        } else if (/\[(\d+)\]$/.test(name)) {
-          const offset = +(/\[(\d+)\]$/.exec(name))[1]
-          if (offset < 0 || offset >= info.size) {
-            return null
-          }
-        }
-        return result
+      if (!this._resolveLink(program)) {
+        this.setError(this.INVALID_OPERATION)
+        return null
+      }
+      const entry = program._uniformLocations.get(name)
+      if (!entry || entry.location < 0) {
+        return null
       }
+      if (!entry.object) {
+        entry.object = new WebGLUniformLocation(entry.location, program, entry.info)
+        entry.object._array = entry.array
+      }
+      return entry.object
     }
     return null
   }
@@ -2103,17 +2218,176 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (this._checkWrapper(program, WebGLProgram)) {
       program._linkCount += 1
       program._attributes = []
+      program._uniformLocations = new Map()
+      program._linkPending = false
       const prevError = this.getError()
-      super.linkProgram(program._ | 0)
+      const reflection = super._linkAndReflect(program._ | 0)
       const error = this.getError()
-      if (error === this.NO_ERROR) {
-        program._linkStatus = this._fixupLink(program)
+      if (error === this.NO_ERROR && reflection) {
+        program._linkStatus = this._fixupLink(program, reflection)
       }
       this.getError()
       this.setError(prevError || error)
     }
   }
 
+  // Starts linking a program and resolves with its link status once the link
+  // has completed and the program has been reflected. Completion is polled
+  // between turns of the event loop, for all pending programs at once, so
+  // many programs can be compiled and linked at the same time on ANGLE's
+  // worker threads.
+  linkProgramAsync (program) {
+    if (!checkObject(program)) {
+      throw new TypeError('linkProgramAsync(WebGLProgram)')
+    }
+    if (!this._checkWrapper(program, WebGLProgram)) {
+      return Promise.resolve(false)
+    }
+
+    const parallel = super._enableParallelShaderCompile()
+    program._linkCount += 1
+    program._attributes = []
+    program._uniformLocations = new Map()
+    const prevError = this.getError()
+    super.linkProgram(program._ | 0)
+    const error = this.getError()
+    program._linkPending = error === this.NO_ERROR
+    this.setError(prevError || error)
+
+    return new Promise((resolve, reject) => {
+      this._pendingLinks.push({ program, parallel, resolve, reject })
+      this._linkPolls = 0
+      this._scheduleLinkPoll()
+    })
+  }
+
+  _scheduleLinkPoll () {
+    if (this._linkPollScheduled) {
+      return
+    }
+    this._linkPollScheduled = true
+    const poll = () => {
+      this._linkPollScheduled = false
+      this._pollLinks()
+    }
+    if (this._linkPolls < LINK_POLL_IMMEDIATE) {
+      setImmediate(poll)
+    } else {
+      setTimeout(poll, Math.min(1 << (this._linkPolls - LINK_POLL_IMMEDIATE), LINK_POLL_MAX_DELAY))
+    }
+  }
+
+  // Settles the promises of the links that have completed, and polls again
+  // later if any are still running
+  _pollLinks () {
+    const pending = this._pendingLinks
+    this._pendingLinks = []
+    let completed = false
+    for (let i = 0; i < pending.length; ++i) {
+      const { program, parallel, resolve, reject } = pending[i]
+      try {
+        if (!program._linkPending) {
+          resolve(program._linkStatus)
+        } else if (program._ === 0 || program._pendingDelete) {
+          // Deleted before the link completed
+          program._linkPending = false
+          resolve(false)
+        } else if (!parallel || this._linkCompleted(program)) {
+          resolve(this._resolveLink(program))
+        } else {
+          this._pendingLinks.push(pending[i])
+          continue
+        }
+        completed = true
+      } catch (e) {
+        // The context was destroyed before the links completed
+        for (const link of this._pendingLinks.concat(pending.slice(i))) {
+          link.reject(e)
+        }
+        this._pendingLinks = []
+        return
+      }
+    }
+    if (this._pendingLinks.length > 0) {
+      this._linkPolls = completed ? 0 : this._linkPolls + 1
+      this._scheduleLinkPoll()
+    }
+  }
+
+  // Polls COMPLETION_STATUS_KHR without touching the application's error state
+  _linkCompleted (program) {
+    this._saveError()
+    const completed = super.getProgramParameter(program._ | 0, COMPLETION_STATUS_KHR)
+    this.getError()
+    this._restoreError(this.NO_ERROR)
+    return !!completed
+  }
+
+  // Compiles and links the programs of the warmPrograms option in the
+  // background, so getWarmProgram can hand them out without waiting for the
+  // compiler. Programs a reset kept are not built again.
+  _warmUpPrograms (manifest) {
+    for (const entry of manifest) {
+      if (this._warmPrograms.has(entry.id)) {
+        continue
+      }
+      const program = this._buildProgram(entry.vertex, entry.fragment, entry.attributes || {})
+      // Only rejects if the context is destroyed first
+      this.linkProgramAsync(program).catch(() => {})
+      this._warmPrograms.set(entry.id, program)
+    }
+  }
+
+  // Creates a program from vertex and fragment sources with its attribute
+  // locations bound, ready to be linked. The shaders are flagged for deletion
+  // so they go away with the program.
+  _buildProgram (vertex, fragment, attributes) {
+    const prevError = this.getError()
+    const program = this.createProgram()
+    for (const [type, source] of [[this.VERTEX_SHADER, vertex], [this.FRAGMENT_SHADER, fragment]]) {
+      const shader = this.createShader(type)
+      this.shaderSource(shader, source)
+      this.compileShader(shader)
+      this.attachShader(program, shader)
+      this.deleteShader(shader)
+    }
+    for (const name of Object.keys(attributes)) {
+      this.bindAttribLocation(program, attributes[name] | 0, name)
+    }
+    this.getError()
+    this.setError(prevError)
+    return program
+  }
+
+  // Returns the program prepared for id by the warmPrograms option, waiting
+  // for its link to finish if it hasn't yet, or null if there is none.
+  getWarmProgram (id) {
+    const program = this._warmPrograms.get(id)
+    if (!program) {
+      return null
+    }
+    this._resolveLink(program)
+    return program
+  }
+
+  // Registers the sources of an uber-shader whose variants are selected with
+  // #define toggles named in features.
+  registerShaderTemplate (id, template) {
+    this._shaderVariants.register(id, template)
+  }
+
+  // Returns the program for a template with the given toggles, compiling it
+  // the first time it is asked for, or null if there is no such template.
+  getVariant (id, defines) {
+    return this._shaderVariants.get(id, defines)
+  }
+
+  // Like getVariant, but resolves once the program has been linked in the
+  // background instead of waiting for it.
+  getVariantAsync (id, defines) {
+    return this._shaderVariants.getAsync(id, defines)
+  }
+
   pixelStorei (pname, param) {
     pname |= 0
     param |= 0
@@ -2142,6 +2416,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
         this.setError(this.INVALID_VALUE)
         return
       }
+    } else if (pname === this.UNPACK_FLIP_Y_WEBGL) {
+      this._unpackFlipY = !!param
+    } else if (pname === this.UNPACK_PREMULTIPLY_ALPHA_WEBGL) {
+      this._unpackPremultiplyAlpha = !!param
     }
     return super.pixelStorei(pname, param)
   }
@@ -2156,6 +2434,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     width |= 0
     height |= 0
 
+    // Reading back the result ends a frame as much as flush() does
+    this._shareGroup.reclaim(this)
+    this._ensureDrawingBuffer()
+
     super.readPixels(
       x,
       y,
@@ -2211,12 +2493,30 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       throw new Error('Invalid surface dimensions')
     } else if (width !== this.drawingBufferWidth ||
       height !== this.drawingBufferHeight) {
-      this._resizeDrawingBuffer(width, height)
+      if (this._drawingBuffer._allocated) {
+        this._resizeDrawingBuffer(width, height)
+      }
       this.drawingBufferWidth = width
       this.drawingBufferHeight = height
     }
   }
 
+  setTextureEvictable (texture, source) {
+    if (!checkObject(texture) || !texture || !checkTextureSource(source)) {
+      throw new TypeError('setTextureEvictable(WebGLTexture, TextureSource)')
+    }
+    if (!this._checkWrapper(texture, WebGLTexture)) {
+      return
+    }
+    // Restoring uploads level 0 and regenerates the other levels from it, so
+    // mipmaps the application uploaded itself would be lost
+    if (source && (!texture._level0 || texture._renderTarget || texture._uploadedMipLevels)) {
+      this.setError(this.INVALID_OPERATION)
+      return
+    }
+    texture._ctx._textureBudget.setEvictable(texture, source)
+  }
+
   sampleCoverage (value, invert) {
     return super.sampleCoverage(+value, !!invert)
   }
@@ -2237,7 +2537,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!isValidString(source)) {
       this.setError(this.INVALID_VALUE)
     } else if (this._checkWrapper(shader, WebGLShader)) {
-      super.shaderSource(shader._ | 0, this._wrapShader(shader._type, source)) // eslint-disable-line
+      super.shaderSource(shader._ | 0, this._wrapShader(shader._type, source), shader._type) // eslint-disable-line
       shader._source = source
     }
   }
@@ -2320,10 +2620,14 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     const data = convertPixels(pixels)
+    if (!checkPixelsType(data, type)) {
+      this.setError(this.INVALID_OPERATION)
+      return
+    }
 
     // Need to check for out of memory error
     this._saveError()
-    super.texImage2D(
+    const replacement = super.texImage2D(
       target,
       level,
       internalFormat,
@@ -2333,12 +2637,30 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       format,
       type,
       data)
+    this._adoptTextureName(target, replacement)
     const error = this.getError()
     this._restoreError(error)
     if (error === this.NO_ERROR) {
       const texture = this._getTexImage(target)
       texture._format = format
       texture._type = type
+      if (target === this.TEXTURE_2D) {
+        // Redefining the texture invalidates whatever source it was evicted from
+        this._pinTexture(texture)
+        if (level === 0) {
+          texture._level0 = {
+            internalFormat,
+            width,
+            height,
+            format,
+            type,
+            flipY: this._unpackFlipY,
+            premultiplyAlpha: this._unpackPremultiplyAlpha,
+            alignment: this._unpackAlignment
+          }
+        }
+        this._updateTextureLevel(texture, level, width * height * pixelSize(format, type))
+      }
     }
   }
 
@@ -2373,6 +2695,14 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     const data = convertPixels(pixels)
+    if (!checkPixelsType(data, type | 0)) {
+      this.setError(this.INVALID_OPERATION)
+      return
+    }
+
+    if ((target | 0) === this.TEXTURE_2D) {
+      this._pinTexture(this._getActiveTexture(this.TEXTURE_2D))
+    }
 
     super.texSubImage2D(
       target,
@@ -2421,6 +2751,26 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return super.texParameteri(target, pname, param)
   }
 
+  // Shrinks the memory the context keeps around to be faster later, for
+  // example when a worker goes idle. Level 1 releases scratch memory, deletes
+  // reclaimable objects and lets ANGLE free its shader compiler. Level 2 also
+  // evicts evictable textures. The drawing buffer is never touched, since it
+  // can be read back at any time. Returns the number of bytes released from
+  // scratch memory and evicted textures.
+  trimMemory (level = 1) {
+    level |= 0
+    if (level < 1) {
+      return 0
+    }
+    this._shareGroup.reclaim(this)
+    const evictedBytes = this._textureBudget._evictedBytes
+    if (level >= 2) {
+      this._textureBudget.evictAll()
+    }
+    const released = super._trimMemory()
+    return released + this._textureBudget._evictedBytes - evictedBytes
+  }
+
   useProgram (program) {
     if (!checkObject(program)) {
       throw new TypeError('useProgram(WebGLProgram)')
@@ -2429,6 +2779,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       this._activeProgram = null
       return super.useProgram(0)
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       if (this._activeProgram !== program) {
         this._switchActiveProgram(this._activeProgram)
         this._activeProgram = program
@@ -2440,6 +2791,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
 
   validateProgram (program) {
     if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       super.validateProgram(program._ | 0)
       const error = this.getError()
       if (error === this.NO_ERROR) {
@@ -2524,13 +2876,123 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return super.viewport(x | 0, y | 0, width | 0, height | 0)
   }
 
-  _allocateDrawingBuffer (width, height) {
+  // Creates the objects of the drawing buffer. Their storage is allocated by
+  // _ensureDrawingBuffer, unless the context was created without one.
+  _createDrawingBuffer (enabled) {
     this._drawingBuffer = new WebGLDrawingBufferWrapper(
       super.createFramebuffer(),
       super.createTexture(),
-      super.createRenderbuffer())
+      super.createRenderbuffer(),
+      enabled)
+  }
+
+  // Sets up the bindings and other state tracked on the JS side, for a new
+  // context or one that has been reset
+  _initState () {
+    this._activeProgram = null
+    this._warmPrograms = new Map()
+    this._shaderVariants = new ShaderVariants(this)
+    this._activeFramebuffers = { read: null, draw: null }
+    this._activeRenderbuffer = null
+    this._checkStencil = false
+    this._stencilState = true
+
+    if (this._isWebGL2()) {
+      this._vaos = {}
+      this._activeVertexArrayObject = null
+    }
+
+    // Initialize texture units
+    const numTextures = this.getParameter(this.MAX_COMBINED_TEXTURE_IMAGE_UNITS)
+    this._textureUnits = new Array(numTextures)
+    for (let i = 0; i < numTextures; ++i) {
+      this._textureUnits[i] = new WebGLTextureUnit(this, i)
+    }
+    this._activeTextureUnit = 0
+    this.activeTexture(this.TEXTURE0)
+
+    this._errorStack = []
+
+    // Vertex array attributes that are in vertex array objects.
+    this._defaultVertexObjectState = new WebGLVertexArrayObjectState(this)
+    this._vertexObjectState = this._defaultVertexObjectState
+
+    // Vertex array attibures that are not in vertex array objects.
+    this._vertexGlobalState = new WebGLVertexArrayGlobalState(this)
+
+    // Unpack alignment
+    this._unpackAlignment = 4
+    this._packAlignment = 4
+    this._unpackFlipY = false
+    this._unpackPremultiplyAlpha = false
+  }
+
+  // Deletes everything the application created and puts the context back in
+  // the state of a new one, with a cleared drawing buffer of the given size.
+  // Extensions stay enabled, and so do the warm programs that haven't been
+  // deleted, along with their shaders. Only used on contexts that share
+  // nothing.
+  _resetState (width, height) {
+    const drawingBuffer = this._drawingBuffer
+    const attrib0Buffer = this._attrib0Buffer
+    const warmPrograms = new Map()
+    const kept = new Set([attrib0Buffer])
+    for (const [id, program] of this._warmPrograms) {
+      if (program._ && !program._pendingDelete) {
+        warmPrograms.set(id, program)
+        kept.add(program)
+        for (const shader of program._references) {
+          kept.add(shader)
+        }
+      }
+    }
+    const keptPrograms = Array.from(warmPrograms.values())
+    const keptShaders = Array.from(kept).filter((object) => object instanceof WebGLShader)
+    super._resetState(
+      [attrib0Buffer._ | 0],
+      [drawingBuffer._framebuffer],
+      [drawingBuffer._depthStencil],
+      [drawingBuffer._color],
+      keptPrograms.map((program) => program._ | 0),
+      keptShaders.map((shader) => shader._ | 0))
+
+    // Wrappers the application still holds no longer name anything
+    const tables = [this._buffers, this._framebuffers, this._programs, this._renderbuffers,
+      this._shaders, this._textures, this._vaos || {}]
+    for (const table of tables) {
+      for (const id in table) {
+        const object = deref(table[id])
+        if (object && !kept.has(object)) {
+          object._ = 0
+        }
+      }
+    }
+    const reclaimObjects = this._shareGroup._registry !== null
+    this._shareGroup.remove(this._buffers, attrib0Buffer)
+    this._shareGroup.leave(this)
+    new WebGLShareGroup(reclaimObjects).join(this)
+    this._framebuffers = {}
+    this._shareGroup.add(this._buffers, attrib0Buffer)
+    attrib0Buffer._refCount = 0
+    for (const program of keptPrograms) {
+      this._shareGroup.add(this._programs, program)
+      program._refCount = 0
+    }
+    for (const shader of keptShaders) {
+      this._shareGroup.add(this._shaders, shader)
+    }
+
+    this._textureBudget = new TextureMemoryBudget(this, this._textureBudget._budget)
+    this._initState()
+    this._warmPrograms = warmPrograms
 
-    this._resizeDrawingBuffer(width, height)
+    this.resize(width, height)
+    this.bindFramebuffer(this.FRAMEBUFFER, null)
+    this.viewport(0, 0, width, height)
+    this.scissor(0, 0, width, height)
+    if (drawingBuffer._allocated) {
+      this.clear(this.COLOR_BUFFER_BIT | this.DEPTH_BUFFER_BIT | this.STENCIL_BUFFER_BIT)
+    }
   }
 
   isContextLost () {
@@ -2896,6 +3358,108 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return super.vertexAttrib4f(index | 0, +value[0], +value[1], +value[2], +value[3])
   }
 
+  blitFramebuffer (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter) {
+    this._ensureDrawingBuffer()
+    return super.blitFramebuffer(
+      srcX0 | 0,
+      srcY0 | 0,
+      srcX1 | 0,
+      srcY1 | 0,
+      dstX0 | 0,
+      dstY0 | 0,
+      dstX1 | 0,
+      dstY1 | 0,
+      mask >>> 0,
+      filter | 0)
+  }
+
+  clearBufferfi (buffer, drawbuffer, depth, stencil) {
+    this._ensureDrawingBuffer()
+    return super.clearBufferfi(buffer | 0, drawbuffer | 0, +depth, stencil | 0)
+  }
+
+  clearBufferfv (buffer, drawbuffer, values) {
+    this._ensureDrawingBuffer()
+    return super.clearBufferfv(
+      buffer | 0,
+      drawbuffer | 0,
+      values instanceof Float32Array ? values : new Float32Array(values))
+  }
+
+  clearBufferiv (buffer, drawbuffer, values) {
+    this._ensureDrawingBuffer()
+    return super.clearBufferiv(
+      buffer | 0,
+      drawbuffer | 0,
+      values instanceof Int32Array ? values : new Int32Array(values))
+  }
+
+  clearBufferuiv (buffer, drawbuffer, values) {
+    this._ensureDrawingBuffer()
+    return super.clearBufferuiv(
+      buffer | 0,
+      drawbuffer | 0,
+      values instanceof Uint32Array ? values : new Uint32Array(values))
+  }
+
+  copyTexSubImage3D (target, level, xoffset, yoffset, zoffset, x, y, width, height) {
+    this._ensureDrawingBuffer()
+    return super.copyTexSubImage3D(
+      target | 0,
+      level | 0,
+      xoffset | 0,
+      yoffset | 0,
+      zoffset | 0,
+      x | 0,
+      y | 0,
+      width | 0,
+      height | 0)
+  }
+
+  drawArraysInstanced (mode, first, count, instanceCount) {
+    mode |= 0
+    first |= 0
+    count |= 0
+    instanceCount |= 0
+
+    this._ensureDrawingBuffer()
+    return super.drawArraysInstanced(mode, first, count, instanceCount)
+  }
+
+  drawElementsInstanced (mode, count, type, ioffset, instanceCount) {
+    mode |= 0
+    count |= 0
+    type |= 0
+    ioffset |= 0
+    instanceCount |= 0
+
+    this._ensureDrawingBuffer()
+    return super.drawElementsInstanced(mode, count, type, ioffset, instanceCount)
+  }
+
+  drawRangeElements (mode, start, end, count, type, ioffset) {
+    mode |= 0
+    start >>>= 0
+    end >>>= 0
+    count |= 0
+    type |= 0
+    ioffset |= 0
+
+    this._ensureDrawingBuffer()
+    return super.drawRangeElements(mode, start, end, count, type, ioffset)
+  }
+
+  texStorage2D (target, levels, internalFormat, width, height) {
+    target |= 0
+    const replacement = super.texStorage2D(
+      target,
+      levels | 0,
+      internalFormat | 0,
+      width | 0,
+      height | 0)
+    this._adoptTextureName(target, replacement)
+  }
+
   _isWebGL2 () {
     return this.TEXTURE_2D_ARRAY !== undefined
   }
@@ -2913,4 +3477,4 @@ class WebGLRenderingContext extends WebGLRenderingContextHelper {}
 
 class WebGL2RenderingContext extends WebGLRenderingContextHelper {}
 
-module.exports = { WebGLRenderingContext, WebGL2RenderingContext, wrapContext }
+module.exports = { WebGLRenderingContext, WebGL2RenderingContext, wrapContext, unwrapContext }
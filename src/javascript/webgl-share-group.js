@@ -0,0 +1,144 @@
+const { gl } = require('./native-gl')
+
+// KHR_debug object identifiers, which _deleteObjectsBatch takes as the type
+const BUFFER = 0x82E0
+const RENDERBUFFER = 0x8D41
+const TEXTURE = 0x1702
+
+// A table entry is the wrapper itself, or a WeakRef to it in groups that
+// reclaim unreachable objects
+function deref (entry) {
+  return entry instanceof WeakRef ? entry.deref() : entry
+}
+
+// The contexts that share buffers, textures, renderbuffers, shaders and
+// programs, along with the wrappers of those objects. Every context starts
+// out in a group of its own; shareWith puts the new context in the group of
+// another one.
+class WebGLShareGroup {
+  constructor (reclaimObjects) {
+    this._contexts = new Set()
+    this._buffers = {}
+    this._programs = {}
+    this._renderbuffers = {}
+    this._shaders = {}
+    this._textures = {}
+
+    // With reclaimObjects, the tables only hold buffers, textures and
+    // renderbuffers weakly. Once the application drops the last reference to
+    // one without deleting it, its finalizer queues it and the next frame
+    // boundary deletes everything queued at once.
+    this._reclaimQueue = []
+    this._registry = reclaimObjects
+      ? new FinalizationRegistry((record) => this._reclaimQueue.push(record))
+      : null
+  }
+
+  join (ctx) {
+    this._contexts.add(ctx)
+    ctx._shareGroup = this
+    ctx._buffers = this._buffers
+    ctx._programs = this._programs
+    ctx._renderbuffers = this._renderbuffers
+    ctx._shaders = this._shaders
+    ctx._textures = this._textures
+  }
+
+  // Hands the objects a context created over to another context of the group
+  // when it is destroyed, since they stay alive as long as any of them does.
+  leave (ctx) {
+    if (!this._contexts.delete(ctx)) {
+      return
+    }
+    const [heir] = this._contexts
+    if (!heir) {
+      return
+    }
+    for (const table of [this._buffers, this._programs, this._renderbuffers, this._shaders]) {
+      for (const id in table) {
+        const object = deref(table[id])
+        if (object && object._ctx === ctx) {
+          object._ctx = heir
+        }
+      }
+    }
+    for (const id in this._textures) {
+      const texture = deref(this._textures[id])
+      if (texture && texture._ctx === ctx) {
+        heir._textureBudget.adopt(texture, ctx._textureBudget)
+        texture._ctx = heir
+        if (texture._reclaim) {
+          texture._reclaim.ctx = heir
+        }
+      }
+    }
+  }
+
+  add (table, object) {
+    if (!this._registry || !(table === this._buffers || table === this._textures ||
+      table === this._renderbuffers)) {
+      table[object._] = object
+      return
+    }
+    const ref = new WeakRef(object)
+    const record = {
+      table,
+      id: object._,
+      ref,
+      type: table === this._buffers ? BUFFER : table === this._textures ? TEXTURE : RENDERBUFFER,
+      // The context whose memory budget counts a texture, and its size there
+      ctx: object._ctx,
+      bytes: 0
+    }
+    table[object._] = ref
+    object._reclaim = record
+    this._registry.register(object, record, object)
+  }
+
+  remove (table, object) {
+    delete table[object._ | 0]
+    if (object._reclaim) {
+      this._registry.unregister(object)
+      object._reclaim = null
+    }
+  }
+
+  // Moves a wrapper to the new name its GL object was given
+  rename (table, object, name) {
+    const entry = table[object._ | 0]
+    delete table[object._ | 0]
+    object._ = name
+    table[name] = entry
+    if (object._reclaim) {
+      object._reclaim.id = name
+    }
+  }
+
+  // Deletes the objects queued since the last call, with one native call per
+  // type
+  reclaim (ctx) {
+    if (this._reclaimQueue.length === 0) {
+      return
+    }
+    const ids = { [BUFFER]: [], [RENDERBUFFER]: [], [TEXTURE]: [] }
+    for (const record of this._reclaimQueue) {
+      // Deleted some other way in the meantime
+      if (record.table[record.id] !== record.ref) {
+        continue
+      }
+      delete record.table[record.id]
+      ids[record.type].push(record.id)
+      if (record.type === TEXTURE) {
+        record.ctx._textureBudget.release(record.bytes)
+      }
+    }
+    this._reclaimQueue = []
+    for (const type of [BUFFER, RENDERBUFFER, TEXTURE]) {
+      if (ids[type].length > 0) {
+        gl._deleteObjectsBatch.call(ctx, type, ids[type])
+      }
+    }
+  }
+}
+
+module.exports = { WebGLShareGroup, deref }
@@ -5,15 +5,27 @@ class WebGLTexture extends Linkable {
   constructor (_, ctx) {
     super(_)
     this._ctx = ctx
+    this._reclaim = null
     this._binding = 0
     this._format = 0
     this._type = 0
     this._complete = true
+
+    // Memory budget bookkeeping, see texture-memory-budget.js
+    this._level0 = null
+    this._levelSize = 0
+    this._byteSize = 0
+    this._mipmapped = false
+    this._uploadedMipLevels = false
+    this._renderTarget = false
+    this._evictSource = null
+    this._evicted = false
   }
 
   _performDelete () {
     const ctx = this._ctx
-    delete ctx._textures[this._ | 0]
+    ctx._shareGroup.remove(ctx._textures, this)
+    ctx._textureBudget.forget(this)
     gl.deleteTexture.call(ctx, this._ | 0)
   }
 }
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "angle-loader/gles_loader.h"
+
+enum GLObjectType {
+  GLOBJECT_TYPE_BUFFER,
+  GLOBJECT_TYPE_FRAMEBUFFER,
+  GLOBJECT_TYPE_PROGRAM,
+  GLOBJECT_TYPE_RENDERBUFFER,
+  GLOBJECT_TYPE_SHADER,
+  GLOBJECT_TYPE_TEXTURE,
+  GLOBJECT_TYPE_VERTEX_ARRAY,
+};
+constexpr int GLOBJECT_TYPE_COUNT = GLOBJECT_TYPE_VERTEX_ARRAY + 1;
+
+using GLObjectReference = std::pair<GLuint, GLObjectType>;
+
+// The memory held by an object. Textures also keep the size of each image,
+// keyed by face target and level, since they are specified one at a time.
+struct GLObjectInfo {
+  size_t bytes = 0;
+  std::map<std::pair<GLenum, GLint>, size_t> images;
+};
+
+// The names of the objects of one type, as a sparse set: the names are packed
+// in an array that can be handed to the array forms of glDelete* as is, and
+// an array indexed by name gives their position in it. GL hands out small
+// names and reuses them, so both stay compact, and adding, finding and
+// removing a name take constant time.
+class GLObjectSet {
+public:
+  GLObjectInfo &insert(GLuint name) {
+    GLObjectInfo *existing = find(name);
+    if (existing) {
+      return *existing;
+    }
+    if (name >= index.size()) {
+      index.resize(static_cast<size_t>(name) + 1);
+    }
+    index[name] = static_cast<uint32_t>(dense.size());
+    dense.push_back(name);
+    info.emplace_back();
+    return info.back();
+  }
+
+  GLObjectInfo *find(GLuint name) {
+    if (name >= index.size()) {
+      return nullptr;
+    }
+    uint32_t i = index[name];
+    return i < dense.size() && dense[i] == name ? &info[i] : nullptr;
+  }
+
+  bool contains(GLuint name) const {
+    return name < index.size() && index[name] < dense.size() && dense[index[name]] == name;
+  }
+
+  // Moves the last name into the hole, so erasing while walking the set
+  // backwards visits every name once.
+  void erase(GLuint name) {
+    if (!contains(name)) {
+      return;
+    }
+    uint32_t i = index[name];
+    if (i + 1 != dense.size()) {
+      GLuint last = dense.back();
+      dense[i] = last;
+      info[i] = std::move(info.back());
+      index[last] = i;
+    }
+    dense.pop_back();
+    info.pop_back();
+  }
+
+  void clear() {
+    dense.clear();
+    info.clear();
+    index.clear();
+  }
+
+  size_t size() const { return dense.size(); }
+  const std::vector<GLuint> &names() const { return dense; }
+  const GLObjectInfo &infoAt(size_t i) const { return info[i]; }
+
+private:
+  std::vector<GLuint> dense;
+  std::vector<GLObjectInfo> info;
+  std::vector<uint32_t> index;
+};
+
+// One set per object type
+class GLObjectRegistry {
+public:
+  GLObjectSet &operator[](GLObjectType type) { return sets[type]; }
+  const GLObjectSet &operator[](GLObjectType type) const { return sets[type]; }
+
+  void clear() {
+    for (GLObjectSet &set : sets) {
+      set.clear();
+    }
+  }
+
+private:
+  GLObjectSet sets[GLOBJECT_TYPE_COUNT];
+};
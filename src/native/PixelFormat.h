@@ -0,0 +1,292 @@
+#ifndef PIXEL_FORMAT_H_
+#define PIXEL_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#define GL_GLES_PROTOTYPES 0
+
+#include "angle-loader/gles_loader.h"
+
+// How the components of a pixel are laid out in memory.
+enum class PixelPacking : uint8_t {
+  // One component per channel, each of the same size
+  None,
+  // All channels packed into a single 16 or 32 bit word
+  Packed16,
+  Packed32,
+  // 32 bit float depth followed by a packed 32 bit word holding stencil
+  Float32UInt248
+};
+
+// How the components are interpreted when they are sampled.
+enum class PixelComponents : uint8_t { Normalized, Integer, Float };
+
+// The copy kernel that applies UNPACK_PREMULTIPLY_ALPHA_WEBGL to a format, or
+// None if the format has no alpha or can't be premultiplied.
+enum class PremultiplyKernel : uint8_t {
+  None,
+  LuminanceAlpha8,
+  RGBA8,
+  RGBA4444,
+  RGBA5551,
+  LuminanceAlphaFloat,
+  RGBAFloat
+};
+
+struct PixelFormatDescriptor {
+  GLenum format;
+  GLenum type;
+  uint8_t channels;
+  uint8_t bytesPerPixel;
+  PixelPacking packing;
+  PixelComponents components;
+  PremultiplyKernel premultiply;
+  bool webgl2Only;
+};
+
+// Every client format/type combination that WebGL 1 and 2 accept for pixel
+// uploads and readback.
+constexpr PixelFormatDescriptor PIXEL_FORMATS[] = {
+    // WebGL 1
+    {GL_RGBA, GL_UNSIGNED_BYTE, 4, 4, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::RGBA8, false},
+    {GL_RGB, GL_UNSIGNED_BYTE, 3, 3, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, false},
+    {GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 2, 2, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::LuminanceAlpha8, false},
+    {GL_LUMINANCE, GL_UNSIGNED_BYTE, 1, 1, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, false},
+    {GL_ALPHA, GL_UNSIGNED_BYTE, 1, 1, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, false},
+    {GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 4, 2, PixelPacking::Packed16,
+     PixelComponents::Normalized, PremultiplyKernel::RGBA4444, false},
+    {GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 4, 2, PixelPacking::Packed16,
+     PixelComponents::Normalized, PremultiplyKernel::RGBA5551, false},
+    {GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 3, 2, PixelPacking::Packed16, PixelComponents::Normalized,
+     PremultiplyKernel::None, false},
+
+    // OES_texture_float, OES_texture_half_float and EXT_sRGB
+    {GL_RGBA, GL_FLOAT, 4, 16, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::RGBAFloat, false},
+    {GL_RGB, GL_FLOAT, 3, 12, PixelPacking::None, PixelComponents::Float, PremultiplyKernel::None,
+     false},
+    {GL_LUMINANCE_ALPHA, GL_FLOAT, 2, 8, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::LuminanceAlphaFloat, false},
+    {GL_LUMINANCE, GL_FLOAT, 1, 4, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, false},
+    {GL_ALPHA, GL_FLOAT, 1, 4, PixelPacking::None, PixelComponents::Float, PremultiplyKernel::None,
+     false},
+    {GL_RGBA, GL_HALF_FLOAT_OES, 4, 8, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, false},
+    {GL_RGB, GL_HALF_FLOAT_OES, 3, 6, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, false},
+    {GL_LUMINANCE_ALPHA, GL_HALF_FLOAT_OES, 2, 4, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, false},
+    {GL_LUMINANCE, GL_HALF_FLOAT_OES, 1, 2, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, false},
+    {GL_ALPHA, GL_HALF_FLOAT_OES, 1, 2, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, false},
+    {GL_SRGB_ALPHA_EXT, GL_UNSIGNED_BYTE, 4, 4, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::RGBA8, false},
+    {GL_SRGB_EXT, GL_UNSIGNED_BYTE, 3, 3, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, false},
+
+    // WebGL 2
+    {GL_RGBA, GL_BYTE, 4, 4, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_RGBA, GL_HALF_FLOAT, 4, 8, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, true},
+    {GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4, 4, PixelPacking::Packed32,
+     PixelComponents::Normalized, PremultiplyKernel::None, true},
+    {GL_RGB, GL_BYTE, 3, 3, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_RGB, GL_HALF_FLOAT, 3, 6, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, true},
+    {GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 3, 4, PixelPacking::Packed32,
+     PixelComponents::Float, PremultiplyKernel::None, true},
+    {GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, 3, 4, PixelPacking::Packed32, PixelComponents::Float,
+     PremultiplyKernel::None, true},
+    {GL_RG, GL_UNSIGNED_BYTE, 2, 2, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_RG, GL_BYTE, 2, 2, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_RG, GL_HALF_FLOAT, 2, 4, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, true},
+    {GL_RG, GL_FLOAT, 2, 8, PixelPacking::None, PixelComponents::Float, PremultiplyKernel::None,
+     true},
+    {GL_RED, GL_UNSIGNED_BYTE, 1, 1, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_RED, GL_BYTE, 1, 1, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_RED, GL_HALF_FLOAT, 1, 2, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, true},
+    {GL_RED, GL_FLOAT, 1, 4, PixelPacking::None, PixelComponents::Float, PremultiplyKernel::None,
+     true},
+    {GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, 4, 4, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGBA_INTEGER, GL_BYTE, 4, 4, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, 4, 8, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGBA_INTEGER, GL_SHORT, 4, 8, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGBA_INTEGER, GL_UNSIGNED_INT, 4, 16, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGBA_INTEGER, GL_INT, 4, 16, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGBA_INTEGER, GL_UNSIGNED_INT_2_10_10_10_REV, 4, 4, PixelPacking::Packed32,
+     PixelComponents::Integer, PremultiplyKernel::None, true},
+    {GL_RGB_INTEGER, GL_UNSIGNED_BYTE, 3, 3, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGB_INTEGER, GL_BYTE, 3, 3, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGB_INTEGER, GL_UNSIGNED_SHORT, 3, 6, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGB_INTEGER, GL_SHORT, 3, 6, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGB_INTEGER, GL_UNSIGNED_INT, 3, 12, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RGB_INTEGER, GL_INT, 3, 12, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RG_INTEGER, GL_UNSIGNED_BYTE, 2, 2, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RG_INTEGER, GL_BYTE, 2, 2, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RG_INTEGER, GL_UNSIGNED_SHORT, 2, 4, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RG_INTEGER, GL_SHORT, 2, 4, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RG_INTEGER, GL_UNSIGNED_INT, 2, 8, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RG_INTEGER, GL_INT, 2, 8, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RED_INTEGER, GL_UNSIGNED_BYTE, 1, 1, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RED_INTEGER, GL_BYTE, 1, 1, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RED_INTEGER, GL_UNSIGNED_SHORT, 1, 2, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RED_INTEGER, GL_SHORT, 1, 2, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RED_INTEGER, GL_UNSIGNED_INT, 1, 4, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_RED_INTEGER, GL_INT, 1, 4, PixelPacking::None, PixelComponents::Integer,
+     PremultiplyKernel::None, true},
+    {GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, 1, 2, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 1, 4, PixelPacking::None, PixelComponents::Normalized,
+     PremultiplyKernel::None, true},
+    {GL_DEPTH_COMPONENT, GL_FLOAT, 1, 4, PixelPacking::None, PixelComponents::Float,
+     PremultiplyKernel::None, true},
+    {GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 2, 4, PixelPacking::Packed32,
+     PixelComponents::Normalized, PremultiplyKernel::None, true},
+    {GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV, 2, 8, PixelPacking::Float32UInt248,
+     PixelComponents::Float, PremultiplyKernel::None, true},
+};
+
+// Looks up a client format/type combination. Returns nullptr if the
+// combination is not one WebGL accepts, or is WebGL 2 only and webgl2 is false.
+constexpr const PixelFormatDescriptor *FindPixelFormat(GLenum format, GLenum type, bool webgl2) {
+  for (const PixelFormatDescriptor &entry : PIXEL_FORMATS) {
+    if (entry.format == format && entry.type == type) {
+      return webgl2 || !entry.webgl2Only ? &entry : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+// Bytes per pixel of a client format/type combination, across both WebGL
+// versions; callers validate the combination against the context first.
+constexpr size_t PixelFormatSize(GLenum format, GLenum type) {
+  const PixelFormatDescriptor *entry = FindPixelFormat(format, type, true);
+  return entry ? entry->bytesPerPixel : 0;
+}
+
+// Bytes between the starts of two rows of an image.
+constexpr size_t PixelRowStride(size_t width, size_t bytesPerPixel, size_t alignment) {
+  return (width * bytesPerPixel + alignment - 1) / alignment * alignment;
+}
+
+// Number of bytes GL reads or writes for an image of the given size, with the
+// last row not padded to the pack or unpack alignment.
+constexpr size_t PixelImageSize(size_t width, size_t height, size_t bytesPerPixel,
+                                size_t alignment) {
+  return height == 0 || width == 0
+             ? 0
+             : PixelRowStride(width, bytesPerPixel, alignment) * (height - 1) +
+                   width * bytesPerPixel;
+}
+
+static_assert(PixelFormatSize(GL_RGBA, GL_UNSIGNED_BYTE) == 4, "RGBA8 is 4 bytes");
+static_assert(PixelFormatSize(GL_RGB, GL_UNSIGNED_SHORT_5_6_5) == 2, "565 is packed");
+static_assert(PixelFormatSize(GL_RGBA_INTEGER, GL_UNSIGNED_INT) == 16, "RGBA32UI is 16 bytes");
+static_assert(PixelFormatSize(GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV) == 4,
+              "RGB10_A2 is packed");
+static_assert(FindPixelFormat(GL_RG, GL_FLOAT, false) == nullptr, "RG is WebGL 2 only");
+static_assert(FindPixelFormat(GL_RGBA, GL_UNSIGNED_BYTE, false)->bytesPerPixel == 4,
+              "RGBA8 is WebGL 1");
+static_assert(PixelImageSize(3, 2, 3, 4) == 12 + 9, "last row is not padded");
+
+// Bytes per texel of a texture or renderbuffer internal format, used to
+// account for the memory they hold. Unsized formats are those WebGL 1 uses.
+// Formats that aren't listed are assumed to take four bytes.
+constexpr size_t InternalFormatSize(GLenum internalformat) {
+  switch (internalformat) {
+  case GL_ALPHA:
+  case GL_LUMINANCE:
+  case GL_ALPHA8_EXT:
+  case GL_LUMINANCE8_EXT:
+  case GL_R8:
+  case GL_R8_SNORM:
+  case GL_R8I:
+  case GL_R8UI:
+  case GL_STENCIL_INDEX8:
+    return 1;
+  case GL_LUMINANCE_ALPHA:
+  case GL_LUMINANCE8_ALPHA8_EXT:
+  case GL_RG8:
+  case GL_RG8_SNORM:
+  case GL_RG8I:
+  case GL_RG8UI:
+  case GL_R16F:
+  case GL_R16I:
+  case GL_R16UI:
+  case GL_RGBA4:
+  case GL_RGB5_A1:
+  case GL_RGB565:
+  case GL_DEPTH_COMPONENT16:
+    return 2;
+  case GL_RGB:
+  case GL_RGB8:
+  case GL_SRGB8:
+  case GL_RGB8_SNORM:
+  case GL_RGB8I:
+  case GL_RGB8UI:
+    return 3;
+  case GL_RGB16F:
+  case GL_RGB16I:
+  case GL_RGB16UI:
+    return 6;
+  case GL_RGBA16F:
+  case GL_RGBA16I:
+  case GL_RGBA16UI:
+  case GL_RG32F:
+  case GL_RG32I:
+  case GL_RG32UI:
+  case GL_DEPTH32F_STENCIL8:
+    return 8;
+  case GL_RGB32F:
+  case GL_RGB32I:
+  case GL_RGB32UI:
+    return 12;
+  case GL_RGBA32F:
+  case GL_RGBA32I:
+  case GL_RGBA32UI:
+    return 16;
+  default:
+    return 4;
+  }
+}
+
+#endif
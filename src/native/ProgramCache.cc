@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Hash.h"
+#include "ProgramCache.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+ProgramCache *INSTANCE = nullptr;
+
+const char ENTRY_MAGIC[8] = {'H', 'G', 'L', 'P', 'C', '0', '0', '1'};
+const char ENTRY_EXTENSION[] = ".bin";
+const char TEMP_EXTENSION[] = ".tmp";
+
+// Temporary files of other processes are only deleted once they are this old,
+// as those processes may still be writing them
+const auto STALE_TEMP_AGE = std::chrono::minutes(10);
+
+struct EntryHeader {
+  char magic[8];
+  uint32_t keySize;
+  uint32_t reserved;
+  uint64_t valueSize;
+  uint64_t checksum;
+};
+
+uint64_t ByteLimit(double bytes) {
+  if (bytes >= static_cast<double>(std::numeric_limits<uint64_t>::max())) {
+    return std::numeric_limits<uint64_t>::max();
+  }
+  return static_cast<uint64_t>(std::max(0.0, bytes));
+}
+
+int ProcessId() {
+#ifdef _WIN32
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+// Calls fn for every file in dir with the given extension. Iterates with
+// error codes, as the addon is built without exceptions.
+template <typename Fn> void ForEachFile(const fs::path &dir, const char *extension, Fn fn) {
+  std::error_code ec;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+    std::error_code entryError;
+    if (it->is_regular_file(entryError) && it->path().extension() == extension) {
+      fn(*it);
+    }
+  }
+}
+
+template <typename Fn> void ForEachEntry(const fs::path &dir, Fn fn) {
+  ForEachFile(dir, ENTRY_EXTENSION, fn);
+}
+
+// The process that wrote a temporary file, from its <entry>.<pid>.<n>.tmp
+// name, or -1 if the name doesn't have that form
+int TempFileOwner(const fs::path &path) {
+  std::string stem = path.stem().string();
+  size_t counter = stem.rfind('.');
+  if (counter == std::string::npos || counter == 0) {
+    return -1;
+  }
+  size_t pid = stem.rfind('.', counter - 1);
+  if (pid == std::string::npos) {
+    return -1;
+  }
+  std::string digits = stem.substr(pid + 1, counter - pid - 1);
+  if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+    return -1;
+  }
+  return atoi(digits.c_str());
+}
+
+// Deletes the temporary files that a crashed or killed process left behind.
+// Entries are written under the lock, so those of this process are never in
+// use while it sweeps.
+void SweepTempFiles(const fs::path &dir) {
+  fs::file_time_type staleBefore = fs::file_time_type::clock::now() - STALE_TEMP_AGE;
+  int pid = ProcessId();
+  ForEachFile(dir, TEMP_EXTENSION, [staleBefore, pid](const fs::directory_entry &entry) {
+    std::error_code ec;
+    fs::file_time_type time = entry.last_write_time(ec);
+    if (TempFileOwner(entry.path()) == pid || (!ec && time < staleBefore)) {
+      fs::remove(entry.path(), ec);
+    }
+  });
+}
+
+} // namespace
+
+bool ProgramCache::Install(EGLDisplay display, const std::string &dir, double maxBytes,
+                           double memoryBytes) {
+  if (INSTANCE) {
+    std::lock_guard<std::mutex> lock(INSTANCE->mutex);
+    return INSTANCE->dir.empty() && !dir.empty() && INSTANCE->attachDirectory(dir, maxBytes);
+  }
+  if (!eglSetBlobCacheFuncsANDROID) {
+    return false;
+  }
+
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions || !strstr(extensions, "EGL_ANDROID_blob_cache")) {
+    return false;
+  }
+
+  ProgramCache *cache = new ProgramCache();
+  cache->memoryLimit = ByteLimit(memoryBytes);
+  if (!dir.empty() && !cache->attachDirectory(dir, maxBytes)) {
+    delete cache;
+    return false;
+  }
+
+  INSTANCE = cache;
+  eglSetBlobCacheFuncsANDROID(display, &ProgramCache::Set, &ProgramCache::Get);
+  return true;
+}
+
+bool ProgramCache::IsInstalled() { return INSTANCE != nullptr; }
+
+std::string ProgramCache::Directory() {
+  if (!INSTANCE) {
+    return std::string();
+  }
+  std::lock_guard<std::mutex> lock(INSTANCE->mutex);
+  return INSTANCE->dir.string();
+}
+
+ProgramCache::Stats ProgramCache::GetStats() {
+  if (!INSTANCE) {
+    return Stats();
+  }
+  std::lock_guard<std::mutex> lock(INSTANCE->mutex);
+  Stats stats = INSTANCE->stats;
+  for (const Timing &timing : INSTANCE->timings) {
+    if (timing.hitCount > 0 && timing.missCount > 0) {
+      double saved = timing.missMs / timing.missCount - timing.hitMs / timing.hitCount;
+      stats.savedMs += timing.hitCount * std::max(0.0, saved);
+    }
+  }
+  return stats;
+}
+
+double ProgramCache::TrimMemory() {
+  if (!INSTANCE) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(INSTANCE->mutex);
+  double released = static_cast<double>(INSTANCE->memoryBytes);
+  INSTANCE->memoryIndex.clear();
+  INSTANCE->memoryEntries.clear();
+  INSTANCE->memoryBytes = 0;
+  INSTANCE->stats.memoryBytes = 0;
+  return released;
+}
+
+ProgramCache::Timer::Timer(Operation operation)
+    : operation(operation), hits(0), start(std::chrono::steady_clock::now()) {
+  if (INSTANCE) {
+    std::lock_guard<std::mutex> lock(INSTANCE->mutex);
+    hits = INSTANCE->stats.hits;
+  }
+}
+
+ProgramCache::Timer::~Timer() {
+  if (!INSTANCE) {
+    return;
+  }
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  std::lock_guard<std::mutex> lock(INSTANCE->mutex);
+  Timing &timing = INSTANCE->timings[operation];
+  if (INSTANCE->stats.hits > hits) {
+    timing.hitCount += 1;
+    timing.hitMs += elapsed.count();
+  } else {
+    timing.missCount += 1;
+    timing.missMs += elapsed.count();
+  }
+}
+
+bool ProgramCache::attachDirectory(const std::string &path, double limit) {
+  std::error_code ec;
+  fs::create_directories(path, ec);
+  if (!fs::is_directory(path, ec)) {
+    return false;
+  }
+
+  dir = fs::path(path);
+  maxBytes = ByteLimit(limit);
+  totalBytes = 0;
+  SweepTempFiles(dir);
+  ForEachEntry(dir, [this](const fs::directory_entry &entry) {
+    std::error_code entryError;
+    uint64_t size = entry.file_size(entryError);
+    totalBytes += entryError ? 0 : size;
+  });
+  stats.bytes = static_cast<double>(totalBytes);
+  return true;
+}
+
+fs::path ProgramCache::entryPath(const void *key, EGLsizeiANDROID keySize) const {
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx",
+           static_cast<unsigned long long>(Fnv1a(key, static_cast<size_t>(keySize))));
+  return dir / (std::string(name) + ENTRY_EXTENSION);
+}
+
+// Reads an entry and checks that it belongs to the key and is intact.
+bool ProgramCache::readEntry(const fs::path &path, const void *key, EGLsizeiANDROID keySize,
+                             std::vector<uint8_t> &value) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  EntryHeader header;
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0 ||
+      header.keySize != static_cast<uint32_t>(keySize)) {
+    return false;
+  }
+
+  std::vector<uint8_t> storedKey(header.keySize);
+  if (!file.read(reinterpret_cast<char *>(storedKey.data()), storedKey.size()) ||
+      memcmp(storedKey.data(), key, storedKey.size()) != 0) {
+    return false;
+  }
+
+  value.resize(header.valueSize);
+  if (!file.read(reinterpret_cast<char *>(value.data()), value.size()) ||
+      Fnv1a(value.data(), value.size()) != header.checksum) {
+    value.clear();
+    return false;
+  }
+
+  // Mark the entry as recently used
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return true;
+}
+
+// Keeps an entry in memory as the most recently used one, then drops the least
+// recently used entries that don't fit. The new entry is always kept, as ANGLE
+// asks for the size of an entry before asking for its contents.
+const std::vector<uint8_t> &ProgramCache::remember(std::string key, std::vector<uint8_t> value) {
+  auto found = memoryIndex.find(key);
+  if (found != memoryIndex.end()) {
+    memoryBytes -= found->second->key.size() + found->second->value.size();
+    memoryEntries.erase(found->second);
+    memoryIndex.erase(found);
+  }
+
+  memoryBytes += key.size() + value.size();
+  memoryEntries.push_front(MemoryEntry{std::move(key), std::move(value)});
+  memoryIndex[memoryEntries.front().key] = memoryEntries.begin();
+
+  while (memoryBytes > memoryLimit && memoryEntries.size() > 1) {
+    const MemoryEntry &last = memoryEntries.back();
+    memoryBytes -= last.key.size() + last.value.size();
+    memoryIndex.erase(last.key);
+    memoryEntries.pop_back();
+  }
+  stats.memoryBytes = static_cast<double>(memoryBytes);
+  return memoryEntries.front().value;
+}
+
+EGLsizeiANDROID ProgramCache::Get(const void *key, EGLsizeiANDROID keySize, void *value,
+                                  EGLsizeiANDROID valueSize) {
+  ProgramCache *cache = INSTANCE;
+  if (!cache || keySize <= 0) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(cache->mutex);
+
+  std::string id(static_cast<const char *>(key), static_cast<size_t>(keySize));
+  const std::vector<uint8_t> *entry = nullptr;
+  auto found = cache->memoryIndex.find(id);
+  if (found != cache->memoryIndex.end()) {
+    cache->memoryEntries.splice(cache->memoryEntries.begin(), cache->memoryEntries,
+                                found->second);
+    entry = &found->second->value;
+  } else if (!cache->dir.empty()) {
+    std::vector<uint8_t> stored;
+    if (cache->readEntry(cache->entryPath(key, keySize), key, keySize, stored)) {
+      entry = &cache->remember(std::move(id), std::move(stored));
+    }
+  }
+
+  if (!entry) {
+    cache->stats.misses += 1;
+    return 0;
+  }
+
+  EGLsizeiANDROID size = static_cast<EGLsizeiANDROID>(entry->size());
+  if (value && valueSize >= size) {
+    memcpy(value, entry->data(), entry->size());
+    cache->stats.hits += 1;
+  }
+  return size;
+}
+
+void ProgramCache::Set(const void *key, EGLsizeiANDROID keySize, const void *value,
+                       EGLsizeiANDROID valueSize) {
+  ProgramCache *cache = INSTANCE;
+  if (!cache || keySize <= 0 || valueSize < 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(cache->mutex);
+
+  const uint8_t *valueBytes = static_cast<const uint8_t *>(value);
+  cache->remember(std::string(static_cast<const char *>(key), static_cast<size_t>(keySize)),
+                  std::vector<uint8_t>(valueBytes, valueBytes + valueSize));
+  cache->stats.writes += 1;
+  if (!cache->dir.empty()) {
+    cache->writeEntry(key, keySize, value, valueSize);
+  }
+}
+
+void ProgramCache::writeEntry(const void *key, EGLsizeiANDROID keySize, const void *value,
+                              EGLsizeiANDROID valueSize) {
+  EntryHeader header;
+  memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+  header.keySize = static_cast<uint32_t>(keySize);
+  header.reserved = 0;
+  header.valueSize = static_cast<uint64_t>(valueSize);
+  header.checksum = Fnv1a(value, static_cast<size_t>(valueSize));
+
+  // Write to a name no other process uses, then rename over the entry so
+  // readers only ever see complete files.
+  fs::path path = entryPath(key, keySize);
+  fs::path temp = path;
+  temp += "." + std::to_string(ProcessId()) + "." + std::to_string(tempCounter++) + ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(static_cast<const char *>(key), keySize);
+    file.write(static_cast<const char *>(value), valueSize);
+    file.close();
+    if (!file) {
+      std::error_code ec;
+      fs::remove(temp, ec);
+      return;
+    }
+  }
+
+  std::error_code ec;
+  uint64_t previousSize = fs::exists(path, ec) ? fs::file_size(path, ec) : 0;
+  if (ec) {
+    previousSize = 0;
+  }
+  fs::rename(temp, path, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+    return;
+  }
+
+  uint64_t entrySize = sizeof(header) + static_cast<uint64_t>(keySize) + valueSize;
+  totalBytes = totalBytes - std::min(totalBytes, previousSize) + entrySize;
+  if (totalBytes > maxBytes) {
+    trim();
+  }
+  stats.bytes = static_cast<double>(totalBytes);
+}
+
+// Deletes least recently used entries until the directory is back to three
+// quarters of its limit, along with stale temporary files. The directory is
+// rescanned because other processes may be writing to it too.
+void ProgramCache::trim() {
+  SweepTempFiles(dir);
+
+  struct Entry {
+    fs::file_time_type time;
+    uint64_t size;
+    fs::path path;
+  };
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+
+  ForEachEntry(dir, [&entries, &total](const fs::directory_entry &entry) {
+    std::error_code entryError;
+    Entry item{entry.last_write_time(entryError), entry.file_size(entryError), entry.path()};
+    if (!entryError) {
+      total += item.size;
+      entries.push_back(std::move(item));
+    }
+  });
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.time < b.time; });
+
+  std::error_code ec;
+  uint64_t target = maxBytes - maxBytes / 4;
+  for (const Entry &entry : entries) {
+    if (total <= target) {
+      break;
+    }
+    if (fs::remove(entry.path, ec)) {
+      total -= entry.size;
+      stats.evictions += 1;
+    }
+  }
+  totalBytes = total;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define EGL_EGL_PROTOTYPES 0
+
+#include "angle-loader/egl_loader.h"
+
+// Process-wide store behind ANGLE's blob cache (EGL_ANDROID_blob_cache), so
+// that contexts share the shaders ANGLE has translated and the programs it
+// has linked instead of producing them again.
+//
+// Entries are kept in memory, least recently used first out, and optionally
+// in a directory so that they outlive the process. Entries on disk are named
+// after their key, written to a temporary file and renamed into place, so
+// processes sharing a directory never see partial entries. Reading an entry
+// refreshes its modification time, and the least recently used entries are
+// deleted once the directory grows past its size limit. Temporary files left
+// behind by processes that died mid-write are swept when the directory is
+// opened and whenever it is trimmed.
+//
+// EGL only accepts one pair of callbacks per display and they carry no user
+// data, so there is a single cache per process.
+class ProgramCache {
+public:
+  struct Stats {
+    double hits = 0;
+    double misses = 0;
+    double writes = 0;
+    double evictions = 0;
+    double bytes = 0;
+    double memoryBytes = 0;
+    // Rough: wall-clock averages, skewed when compiles run in parallel
+    double savedMs = 0;
+  };
+
+  enum Operation { COMPILE, LINK, OPERATION_COUNT };
+
+  // Times a compile or link while it is in scope. Operations that hit the
+  // cache are compared with those that missed to estimate the time saved.
+  class Timer {
+  public:
+    explicit Timer(Operation operation);
+    ~Timer();
+
+  private:
+    Operation operation;
+    double hits;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  // Installs the cache on a display, keeping up to memoryBytes of entries in
+  // memory and, if dir isn't empty, up to maxBytes in dir. A directory can be
+  // added to a cache that was installed without one. Returns false if the
+  // display doesn't support blob caches or the directory can't be created.
+  static bool Install(EGLDisplay display, const std::string &dir, double maxBytes,
+                      double memoryBytes);
+
+  static bool IsInstalled();
+  static std::string Directory();
+  static Stats GetStats();
+
+  // Drops the entries kept in memory, which are read back from the directory
+  // if there is one. Returns the number of bytes released.
+  static double TrimMemory();
+
+private:
+  struct MemoryEntry {
+    std::string key;
+    std::vector<uint8_t> value;
+  };
+
+  struct Timing {
+    double hitCount = 0;
+    double hitMs = 0;
+    double missCount = 0;
+    double missMs = 0;
+  };
+
+  static void Set(const void *key, EGLsizeiANDROID keySize, const void *value,
+                  EGLsizeiANDROID valueSize);
+  static EGLsizeiANDROID Get(const void *key, EGLsizeiANDROID keySize, void *value,
+                             EGLsizeiANDROID valueSize);
+
+  bool attachDirectory(const std::string &dir, double maxBytes);
+  std::filesystem::path entryPath(const void *key, EGLsizeiANDROID keySize) const;
+  bool readEntry(const std::filesystem::path &path, const void *key, EGLsizeiANDROID keySize,
+                 std::vector<uint8_t> &value);
+  void writeEntry(const void *key, EGLsizeiANDROID keySize, const void *value,
+                  EGLsizeiANDROID valueSize);
+  const std::vector<uint8_t> &remember(std::string key, std::vector<uint8_t> value);
+  void trim();
+
+  std::mutex mutex;
+  Stats stats;
+  Timing timings[OPERATION_COUNT];
+
+  // Entries in memory, most recently used first
+  std::list<MemoryEntry> memoryEntries;
+  std::unordered_map<std::string, std::list<MemoryEntry>::iterator> memoryIndex;
+  uint64_t memoryLimit = 0;
+  uint64_t memoryBytes = 0;
+
+  // Entries on disk
+  std::filesystem::path dir;
+  uint64_t maxBytes = 0;
+  uint64_t totalBytes = 0;
+  uint64_t tempCounter = 0;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHADER_SOURCE_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// WebGL only accepts shader sources and identifiers made of the GLSL ES
+// character set, outside of comments. The characters that can't appear are
+// ", $, `, @, \, ' and NUL.
+inline bool IsForbiddenShaderChar(char c) {
+  switch (c) {
+  case '"':
+  case '$':
+  case '`':
+  case '@':
+  case '\\':
+  case '\'':
+  case '\0':
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Returns the offset of the first byte at or after start that is either
+// forbidden or '/', the only byte that can begin a comment. Runs of ordinary
+// code are skipped sixteen bytes at a time where SSE2 is available.
+inline size_t FindShaderSpecialChar(const char *data, size_t length, size_t start) {
+  size_t i = start;
+#ifdef SHADER_SOURCE_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i dollar = _mm_set1_epi8('$');
+  const __m128i backtick = _mm_set1_epi8('`');
+  const __m128i at = _mm_set1_epi8('@');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i apostrophe = _mm_set1_epi8('\'');
+  const __m128i nul = _mm_setzero_si128();
+  const __m128i slash = _mm_set1_epi8('/');
+  for (; i + 16 <= length; i += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i found = _mm_or_si128(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, dollar)),
+                     _mm_or_si128(_mm_cmpeq_epi8(chunk, backtick), _mm_cmpeq_epi8(chunk, at))),
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, backslash), _mm_cmpeq_epi8(chunk, apostrophe)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, nul), _mm_cmpeq_epi8(chunk, slash))));
+    int mask = _mm_movemask_epi8(found);
+    if (mask != 0) {
+#if defined(_MSC_VER) && !defined(__clang__)
+      unsigned long bit;
+      _BitScanForward(&bit, static_cast<unsigned long>(mask));
+      return i + bit;
+#else
+      return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+#endif
+    }
+  }
+#endif
+  for (; i < length; ++i) {
+    if (data[i] == '/' || IsForbiddenShaderChar(data[i])) {
+      return i;
+    }
+  }
+  return length;
+}
+
+// Checks a shader source or identifier in a single pass, skipping over
+// comments. An unterminated block comment runs to the end of the source, as
+// it does for the GLSL preprocessor.
+inline bool IsValidShaderSource(const char *data, size_t length) {
+  size_t i = 0;
+  while ((i = FindShaderSpecialChar(data, length, i)) < length) {
+    if (data[i] != '/') {
+      return false;
+    }
+    if (i + 1 < length && data[i + 1] == '/') {
+      const void *end = memchr(data + i + 2, '\n', length - i - 2);
+      if (!end) {
+        return true;
+      }
+      i = static_cast<const char *>(end) - data + 1;
+    } else if (i + 1 < length && data[i + 1] == '*') {
+      i += 2;
+      for (;;) {
+        const void *star = i < length ? memchr(data + i, '*', length - i) : nullptr;
+        if (!star) {
+          return true;
+        }
+        i = static_cast<const char *>(star) - data + 1;
+        if (i < length && data[i] == '/') {
+          i += 1;
+          break;
+        }
+      }
+    } else {
+      i += 1;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <mutex>
+
+#include "Hash.h"
+#include "ShaderStats.h"
+#include "SharedLibrary.h"
+#include "platform/PlatformMethods.h"
+
+namespace {
+
+std::mutex HISTOGRAM_MUTEX;
+std::map<std::string, ShaderStats::Histogram> HISTOGRAMS;
+
+// ANGLE caps the number of histograms it reports, but don't trust that
+const size_t MAX_HISTOGRAMS = 256;
+
+void AddSample(ShaderStats::Entry &entry, double ms) {
+  entry.totalMs += ms;
+  entry.maxMs = std::max(entry.maxMs, ms);
+}
+
+// Histogram samples can arrive from ANGLE's worker threads
+void RecordHistogram(const char *name, double sample) {
+  std::lock_guard<std::mutex> lock(HISTOGRAM_MUTEX);
+  auto found = HISTOGRAMS.find(name);
+  if (found == HISTOGRAMS.end()) {
+    if (HISTOGRAMS.size() >= MAX_HISTOGRAMS) {
+      return;
+    }
+    found = HISTOGRAMS.emplace(name, ShaderStats::Histogram()).first;
+    found->second.min = sample;
+    found->second.max = sample;
+  }
+  ShaderStats::Histogram &histogram = found->second;
+  histogram.count += 1;
+  histogram.sum += sample;
+  histogram.min = std::min(histogram.min, sample);
+  histogram.max = std::max(histogram.max, sample);
+}
+
+void HistogramCustomCounts(angle::PlatformMethods *, const char *name, int sample, int, int,
+                           int) {
+  RecordHistogram(name, sample);
+}
+
+void HistogramEnumeration(angle::PlatformMethods *, const char *name, int sample, int) {
+  RecordHistogram(name, sample);
+}
+
+void HistogramSparse(angle::PlatformMethods *, const char *name, int sample) {
+  RecordHistogram(name, sample);
+}
+
+void HistogramBoolean(angle::PlatformMethods *, const char *name, bool sample) {
+  RecordHistogram(name, sample ? 1 : 0);
+}
+
+} // namespace
+
+void ShaderStats::shaderSource(GLuint shader, GLenum type, const char *source, size_t length) {
+  uint64_t hash = Fnv1a(source, length);
+  auto previous = shaderHashes.find(shader);
+  if (previous != shaderHashes.end()) {
+    if (previous->second == hash) {
+      return;
+    }
+    shaders[previous->second].ids.erase(shader);
+  }
+  shaderHashes[shader] = hash;
+
+  Entry &entry = shaders[hash];
+  entry.type = type;
+  entry.sourceBytes = static_cast<double>(length);
+  entry.ids.insert(shader);
+  entry.lastUsed = ++uses;
+  prune(shaders);
+}
+
+void ShaderStats::compileStarted(GLuint shader, double ms) {
+  auto hash = shaderHashes.find(shader);
+  if (hash == shaderHashes.end()) {
+    return;
+  }
+  Entry &entry = shaders[hash->second];
+  entry.count += 1;
+  AddSample(entry, ms);
+  pendingCompiles[shader] = PendingCompile{hash->second, ms};
+}
+
+void ShaderStats::compileResolved(GLuint shader, double ms) {
+  resolve(shaders, pendingCompiles, shader, ms);
+}
+
+void ShaderStats::resolve(std::map<uint64_t, Entry> &entries,
+                          std::map<GLuint, PendingCompile> &pending, GLuint id, double ms) {
+  auto found = pending.find(id);
+  if (found == pending.end()) {
+    return;
+  }
+  Entry &entry = entries[found->second.hash];
+  entry.totalMs += ms;
+  entry.maxMs = std::max(entry.maxMs, found->second.ms + ms);
+  pending.erase(found);
+}
+
+void ShaderStats::linkStarted(GLuint program, double ms) {
+  GLint attachedCount = 0;
+  glGetProgramiv(program, GL_ATTACHED_SHADERS, &attachedCount);
+  std::vector<GLuint> attached(std::max(attachedCount, 0));
+  GLsizei count = 0;
+  glGetAttachedShaders(program, attachedCount, &count, attached.data());
+  attached.resize(std::max(count, 0));
+  std::sort(attached.begin(), attached.end());
+
+  uint64_t hash = Fnv1a(nullptr, 0);
+  double sourceBytes = 0;
+  for (GLuint shader : attached) {
+    auto shaderHash = shaderHashes.find(shader);
+    if (shaderHash != shaderHashes.end()) {
+      hash = Fnv1a(&shaderHash->second, sizeof(shaderHash->second), hash);
+      sourceBytes += shaders[shaderHash->second].sourceBytes;
+    }
+  }
+
+  auto previous = programHashes.find(program);
+  if (previous != programHashes.end() && previous->second != hash) {
+    programs[previous->second].ids.erase(program);
+  }
+  programHashes[program] = hash;
+
+  Entry &entry = programs[hash];
+  entry.sourceBytes = sourceBytes;
+  entry.count += 1;
+  AddSample(entry, ms);
+  entry.ids.insert(program);
+  entry.lastUsed = ++uses;
+  pendingLinks[program] = PendingCompile{hash, ms};
+  prune(programs);
+}
+
+void ShaderStats::linkResolved(GLuint program, double ms) {
+  resolve(programs, pendingLinks, program, ms);
+}
+
+void ShaderStats::forget(std::map<uint64_t, Entry> &entries, std::map<GLuint, uint64_t> &hashes,
+                         GLuint id) {
+  auto hash = hashes.find(id);
+  if (hash != hashes.end()) {
+    entries[hash->second].ids.erase(id);
+    hashes.erase(hash);
+  }
+}
+
+// Entries of live shaders and programs are kept even past the limit, since
+// there can only be as many of them as there are GL objects
+void ShaderStats::prune(std::map<uint64_t, Entry> &entries) {
+  while (entries.size() > MAX_ENTRIES) {
+    auto oldest = entries.end();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      if (it->second.ids.empty() &&
+          (oldest == entries.end() || it->second.lastUsed < oldest->second.lastUsed)) {
+        oldest = it;
+      }
+    }
+    if (oldest == entries.end()) {
+      return;
+    }
+    entries.erase(oldest);
+  }
+}
+
+void ShaderStats::deleteShader(GLuint shader) {
+  forget(shaders, shaderHashes, shader);
+  pendingCompiles.erase(shader);
+}
+
+void ShaderStats::deleteProgram(GLuint program) {
+  forget(programs, programHashes, program);
+  pendingLinks.erase(program);
+}
+
+bool ShaderStats::InstallPlatform(EGLDisplay display) {
+  // The platform entry point lives in ANGLE's GLES library, which stays
+  // loaded for the rest of the process once it has been opened here
+  static SharedLibrary glesLibrary;
+  static bool opened = glesLibrary.open("libGLESv2");
+  if (!opened) {
+    return false;
+  }
+
+  auto getDisplayPlatform =
+      glesLibrary.getFunction<angle::GetDisplayPlatformFunc>("ANGLEGetDisplayPlatform");
+  angle::PlatformMethods *platform = nullptr;
+  if (!getDisplayPlatform ||
+      !getDisplayPlatform(display, angle::g_PlatformMethodNames, angle::g_NumPlatformMethods,
+                          nullptr, &platform) ||
+      !platform) {
+    return false;
+  }
+
+  platform->histogramCustomCounts = HistogramCustomCounts;
+  platform->histogramEnumeration = HistogramEnumeration;
+  platform->histogramSparse = HistogramSparse;
+  platform->histogramBoolean = HistogramBoolean;
+  return true;
+}
+
+std::map<std::string, ShaderStats::Histogram> ShaderStats::GetHistograms() {
+  std::lock_guard<std::mutex> lock(HISTOGRAM_MUTEX);
+  return HISTOGRAMS;
+}
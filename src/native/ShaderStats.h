@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "angle-loader/egl_loader.h"
+#include "angle-loader/gles_loader.h"
+
+// Compile and link times of one context, grouped by source so that shaders
+// and programs built several times show up once with their totals. Times are
+// those the calling thread spends blocked in glCompileShader, in the first
+// COMPILE_STATUS query after it, and in glLinkProgram and reading back the
+// linked program.
+//
+// Histograms that ANGLE reports through its platform methods, which include
+// the times of its translator and backend compile phases, are collected for
+// the whole process.
+class ShaderStats {
+public:
+  struct Entry {
+    GLenum type = 0;
+    double sourceBytes = 0;
+    double count = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    std::set<GLuint> ids;
+    uint64_t lastUsed = 0;
+  };
+
+  struct Histogram {
+    double count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+  };
+
+  static double Now() {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void shaderSource(GLuint shader, GLenum type, const char *source, size_t length);
+  void compileStarted(GLuint shader, double ms);
+  bool compilePending(GLuint shader) const { return pendingCompiles.count(shader) > 0; }
+  void compileResolved(GLuint shader, double ms);
+  void linkStarted(GLuint program, double ms);
+  void linkResolved(GLuint program, double ms);
+  void deleteShader(GLuint shader);
+  void deleteProgram(GLuint program);
+
+  // Entries keyed by the FNV-1a hash of the source, or for programs of the
+  // hashes of their attached shaders. Past MAX_ENTRIES, the least recently
+  // used entries that no live shader or program refers to are dropped.
+  static const size_t MAX_ENTRIES = 1024;
+  std::map<uint64_t, Entry> shaders;
+  std::map<uint64_t, Entry> programs;
+
+  // Hooks ANGLE's histogram platform methods on a display before it is
+  // initialized. Returns false if this ANGLE doesn't export them.
+  static bool InstallPlatform(EGLDisplay display);
+  static std::map<std::string, Histogram> GetHistograms();
+
+private:
+  // A compile or link whose result hasn't been waited for yet
+  struct PendingCompile {
+    uint64_t hash;
+    double ms;
+  };
+
+  void forget(std::map<uint64_t, Entry> &entries, std::map<GLuint, uint64_t> &hashes, GLuint id);
+  static void prune(std::map<uint64_t, Entry> &entries);
+  static void resolve(std::map<uint64_t, Entry> &entries,
+                      std::map<GLuint, PendingCompile> &pending, GLuint id, double ms);
+
+  std::map<GLuint, uint64_t> shaderHashes;
+  std::map<GLuint, uint64_t> programHashes;
+  std::map<GLuint, PendingCompile> pendingCompiles;
+  std::map<GLuint, PendingCompile> pendingLinks;
+  uint64_t uses = 0;
+};
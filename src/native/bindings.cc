@@ -34,6 +34,8 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("_drawArraysInstancedANGLE", DrawArraysInstancedANGLE);
   JS_GL_METHOD("_drawElementsInstancedANGLE", DrawElementsInstancedANGLE);
   JS_GL_METHOD("_vertexAttribDivisorANGLE", VertexAttribDivisorANGLE);
+  JS_GL_METHOD("_maxShaderCompilerThreadsKHR", MaxShaderCompilerThreadsKHR);
+  JS_GL_METHOD("_enableParallelShaderCompile", EnableParallelShaderCompile);
 
   JS_GL_METHOD("getUniform", GetUniform);
   JS_GL_METHOD("uniform1f", Uniform1f);
@@ -63,6 +65,8 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("createProgram", CreateProgram);
   JS_GL_METHOD("attachShader", AttachShader);
   JS_GL_METHOD("linkProgram", LinkProgram);
+  JS_GL_METHOD("_linkAndReflect", LinkAndReflect);
+  JS_GL_METHOD("_reflectProgram", ReflectProgram);
   JS_GL_METHOD("getProgramParameter", GetProgramParameter);
   JS_GL_METHOD("getUniformLocation", GetUniformLocation);
   JS_GL_METHOD("clearColor", ClearColor);
@@ -71,6 +75,10 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("createTexture", CreateTexture);
   JS_GL_METHOD("bindTexture", BindTexture);
   JS_GL_METHOD("texImage2D", TexImage2D);
+  JS_GL_METHOD("getTextureStorageStats", GetTextureStorageStats);
+  JS_GL_METHOD("_unpromoteTextures", UnpromoteTextures);
+  JS_GL_METHOD("getProgramCacheStats", GetProgramCacheStats);
+  JS_GL_METHOD("_getShaderStats", GetShaderStats);
   JS_GL_METHOD("texParameteri", TexParameteri);
   JS_GL_METHOD("texParameterf", TexParameterf);
   JS_GL_METHOD("clear", Clear);
@@ -156,6 +164,11 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("frontFace", FrontFace);
   JS_GL_METHOD("sampleCoverage", SampleCoverage);
   JS_GL_METHOD("destroy", Destroy);
+  JS_GL_METHOD("_resetState", ResetState);
+  JS_GL_METHOD("_getMemoryInfo", GetMemoryInfo);
+  JS_GL_METHOD("_deleteObjectsBatch", DeleteObjectsBatch);
+  JS_GL_METHOD("_trimMemory", TrimMemory);
+  JS_GL_METHOD("_resizeDrawingBuffer", ResizeDrawingBuffer);
   JS_GL_METHOD("drawBuffersWEBGL", DrawBuffersWEBGL);
   JS_GL_METHOD("extWEBGL_draw_buffers", EXTWEBGL_draw_buffers);
   JS_GL_METHOD("createVertexArrayOES", CreateVertexArrayOES);
@@ -177,6 +190,7 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("texStorage3D", TexStorage3D);
   JS_GL_METHOD("texImage3D", TexImage3D);
   JS_GL_METHOD("texSubImage3D", TexSubImage3D);
+  JS_GL_METHOD("texSubImage3DLayers", TexSubImage3DLayers);
   JS_GL_METHOD("copyTexSubImage3D", CopyTexSubImage3D);
   JS_GL_METHOD("compressedTexImage3D", CompressedTexImage3D);
   JS_GL_METHOD("compressedTexSubImage3D", CompressedTexSubImage3D);
@@ -564,6 +578,9 @@ NAN_MODULE_INIT(Init) {
   // Export helper methods for clean up and error handling
   Nan::Export(target, "cleanup", WebGLRenderingContext::DisposeAll);
   Nan::Export(target, "setError", WebGLRenderingContext::SetError);
+  Nan::Export(target, "pixelFormatSize", WebGLRenderingContext::GetPixelFormatSize);
+  Nan::Export(target, "validateShaderSource", WebGLRenderingContext::ValidateShaderSource);
+  Nan::Export(target, "trimProgramCache", WebGLRenderingContext::TrimProgramCache);
 }
 
 void BindWebGL2(const Nan::FunctionCallbackInfo<v8::Value> &info) {
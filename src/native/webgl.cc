@@ -1,4 +1,6 @@
 #include <array>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -143,8 +145,41 @@ std::string JoinStringSet(const std::set<std::string> &inputSet,
   return oss.str();
 }
 
+// The bytes behind an ArrayBufferView (typed arrays, DataView and Node Buffer),
+// ArrayBuffer or SharedArrayBuffer. The memory is used in place, without copying.
+struct ArrayBufferContents {
+  uint8_t *data = nullptr;
+  size_t byteLength = 0;
+};
+
+ArrayBufferContents GetArrayBufferContents(v8::Local<v8::Value> value) {
+  ArrayBufferContents contents;
+  if (value->IsArrayBufferView()) {
+    v8::Local<v8::ArrayBufferView> view = value.As<v8::ArrayBufferView>();
+    contents.byteLength = view->ByteLength();
+    if (contents.byteLength > 0) {
+      contents.data = static_cast<uint8_t *>(view->Buffer()->Data()) + view->ByteOffset();
+    }
+  } else if (value->IsArrayBuffer()) {
+    v8::Local<v8::ArrayBuffer> buffer = value.As<v8::ArrayBuffer>();
+    contents.data = static_cast<uint8_t *>(buffer->Data());
+    contents.byteLength = buffer->ByteLength();
+  } else if (value->IsSharedArrayBuffer()) {
+    v8::Local<v8::SharedArrayBuffer> buffer = value.As<v8::SharedArrayBuffer>();
+    contents.data = static_cast<uint8_t *>(buffer->Data());
+    contents.byteLength = buffer->ByteLength();
+  }
+  return contents;
+}
+
 bool WebGLRenderingContext::HAS_DISPLAY = false;
 EGLDisplay WebGLRenderingContext::DISPLAY;
+bool WebGLRenderingContext::SURFACELESS = false;
+bool WebGLRenderingContext::PROGRAM_CACHE_CONTROL = false;
+SharedLibrary WebGLRenderingContext::EGL_LIBRARY;
+bool WebGLRenderingContext::GLES_LOADED = false;
+WebGLRenderingContext::DisplayCache WebGLRenderingContext::DISPLAY_CACHES[2];
+std::map<EGLConfig, EGLSurface> WebGLRenderingContext::SHARED_SURFACES;
 WebGLRenderingContext *WebGLRenderingContext::ACTIVE = NULL;
 WebGLRenderingContext *WebGLRenderingContext::CONTEXT_LIST_HEAD = NULL;
 
@@ -164,7 +199,7 @@ bool ContextSupportsExtensions(WebGLRenderingContext *inst,
                                const std::vector<std::string> &extensions) {
   for (const std::string &extension : extensions) {
     if (inst->enabledExtensions.count(extension) == 0 &&
-        inst->requestableExtensions.count(extension) == 0) {
+        inst->requestableExtensions->count(extension) == 0) {
       return false;
     }
   }
@@ -172,33 +207,76 @@ bool ContextSupportsExtensions(WebGLRenderingContext *inst,
 }
 
 bool CaseInsensitiveCompare(const std::string &a, const std::string &b) {
-  std::string aLower = a;
-  std::string bLower = b;
-  std::transform(aLower.begin(), aLower.end(), aLower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-  std::transform(bLower.begin(), bLower.end(), bLower.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-  return aLower < bLower;
-};
+  return std::lexicographical_compare(
+      a.begin(), a.end(), b.begin(), b.end(),
+      [](unsigned char x, unsigned char y) { return std::tolower(x) < std::tolower(y); });
+}
+
+const WebGLToANGLEExtensionsMap &WebGLRenderingContext::WebGLToANGLEExtensions(bool webgl2) {
+  static const WebGLToANGLEExtensionsMap maps[2] = {
+      // Each WebGL extension maps to one or more required ANGLE extensions.
+      WebGLToANGLEExtensionsMap(
+          {
+              {"STACKGL_destroy_context", {}},
+              {"STACKGL_resize_drawingbuffer", {}},
+              {"EXT_texture_filter_anisotropic", {"GL_EXT_texture_filter_anisotropic"}},
+              {"OES_texture_float_linear", {"GL_OES_texture_float_linear"}},
+              {"KHR_parallel_shader_compile", {"GL_KHR_parallel_shader_compile"}},
+              {"ANGLE_instanced_arrays", {"GL_ANGLE_instanced_arrays"}},
+              {"OES_element_index_uint", {"GL_OES_element_index_uint"}},
+              {"EXT_blend_minmax", {"GL_EXT_blend_minmax"}},
+              {"OES_standard_derivatives", {"GL_OES_standard_derivatives"}},
+              {"OES_texture_float",
+               {"GL_OES_texture_float", "GL_CHROMIUM_color_buffer_float_rgba",
+                "GL_CHROMIUM_color_buffer_float_rgb"}},
+              {"WEBGL_draw_buffers", {"GL_EXT_draw_buffers"}},
+              {"OES_vertex_array_object", {"GL_OES_vertex_array_object"}},
+              {"EXT_shader_texture_lod", {"GL_EXT_shader_texture_lod"}},
+          },
+          &CaseInsensitiveCompare),
+      WebGLToANGLEExtensionsMap(
+          {
+              {"STACKGL_destroy_context", {}},
+              {"STACKGL_resize_drawingbuffer", {}},
+              {"EXT_texture_filter_anisotropic", {"GL_EXT_texture_filter_anisotropic"}},
+              {"OES_texture_float_linear", {"GL_OES_texture_float_linear"}},
+              {"KHR_parallel_shader_compile", {"GL_KHR_parallel_shader_compile"}},
+              {"EXT_color_buffer_float", {"GL_EXT_color_buffer_float"}},
+          },
+          &CaseInsensitiveCompare),
+  };
+  return maps[webgl2 ? 1 : 0];
+}
 
 WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha, bool depth,
                                              bool stencil, bool antialias, bool premultipliedAlpha,
                                              bool preserveDrawingBuffer,
                                              bool preferLowPowerToHighPerformance,
                                              bool failIfMajorPerformanceCaveat,
-                                             bool createWebGL2Context)
+                                             bool createWebGL2Context, bool promoteTextureStorage,
+                                             const std::string &programCacheDir,
+                                             double programCacheMaxBytes,
+                                             double programCacheMemoryBytes,
+                                             WebGLRenderingContext *shareContext,
+                                             double memoryLimit)
     : state(GLCONTEXT_STATE_INIT), unpack_flip_y(false), unpack_premultiply_alpha(false),
       unpack_colorspace_conversion(0x9244), unpack_alignment(4),
-      webGLToANGLEExtensions(&CaseInsensitiveCompare), next(NULL), prev(NULL) {
+      webGLToANGLEExtensions(&WebGLToANGLEExtensions(createWebGL2Context)),
+      memoryLimit(memoryLimit), next(NULL), prev(NULL), webgl2(createWebGL2Context),
+      promoteTextureStorage(promoteTextureStorage), maxTextureSize(0), activeTextureUnit(0),
+      promotedTextures(0), avoidedReallocations(0), demotedMipChains(0) {
+  drawingBuffer.alpha = alpha;
+  drawingBuffer.depth = depth;
+  drawingBuffer.stencil = stencil;
 
   if (!eglGetProcAddress) {
-    if (!eglLibrary.open("libEGL")) {
+    if (!EGL_LIBRARY.open("libEGL")) {
       errorMessage = "Error opening ANGLE shared library.";
       state = GLCONTEXT_STATE_ERROR;
       return;
     }
 
-    auto getProcAddress = eglLibrary.getFunction<PFNEGLGETPROCADDRESSPROC>("eglGetProcAddress");
+    auto getProcAddress = EGL_LIBRARY.getFunction<PFNEGLGETPROCADDRESSPROC>("eglGetProcAddress");
     ::LoadEGL(getProcAddress);
   }
 
@@ -211,6 +289,10 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
       return;
     }
 
+    // Collect ANGLE's compile histograms, which has to be set up before the
+    // display is initialized
+    ShaderStats::InstallPlatform(DISPLAY);
+
     // Initialize EGL
     if (!eglInitialize(DISPLAY, NULL, NULL)) {
       errorMessage = "Error initializing EGL.";
@@ -218,35 +300,53 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
       return;
     }
 
+    const char *displayExtensions = eglQueryString(DISPLAY, EGL_EXTENSIONS);
+    SURFACELESS = displayExtensions && strstr(displayExtensions, "EGL_KHR_surfaceless_context");
+    PROGRAM_CACHE_CONTROL =
+        displayExtensions && strstr(displayExtensions, "EGL_ANGLE_program_cache_control");
+
     // Save display
     HAS_DISPLAY = true;
   }
 
+  // The blob cache belongs to the display, so only the first context that asks
+  // for one picks its limits, and the first that passes a directory picks that.
+  if (!programCacheDir.empty() || programCacheMemoryBytes > 0) {
+    ProgramCache::Install(DISPLAY, programCacheDir, programCacheMaxBytes,
+                          programCacheMemoryBytes);
+  }
+
+  DisplayCache &cache = DISPLAY_CACHES[createWebGL2Context ? 1 : 0];
+
   // Set up configuration
-  EGLint renderableTypeBit = createWebGL2Context ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_ES3_BIT;
-  EGLint attrib_list[] = {EGL_SURFACE_TYPE,
-                          EGL_PBUFFER_BIT,
-                          EGL_RED_SIZE,
-                          8,
-                          EGL_GREEN_SIZE,
-                          8,
-                          EGL_BLUE_SIZE,
-                          8,
-                          EGL_ALPHA_SIZE,
-                          8,
-                          EGL_DEPTH_SIZE,
-                          24,
-                          EGL_STENCIL_SIZE,
-                          8,
-                          EGL_RENDERABLE_TYPE,
-                          renderableTypeBit,
-                          EGL_NONE};
-  EGLint num_config;
-  if (!eglChooseConfig(DISPLAY, attrib_list, &config, 1, &num_config) || num_config != 1) {
-    errorMessage = "Error choosing EGL config.";
-    state = GLCONTEXT_STATE_ERROR;
-    return;
+  if (!cache.ready) {
+    EGLint renderableTypeBit = createWebGL2Context ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_ES3_BIT;
+    EGLint attrib_list[] = {EGL_SURFACE_TYPE,
+                            EGL_PBUFFER_BIT,
+                            EGL_RED_SIZE,
+                            8,
+                            EGL_GREEN_SIZE,
+                            8,
+                            EGL_BLUE_SIZE,
+                            8,
+                            EGL_ALPHA_SIZE,
+                            8,
+                            EGL_DEPTH_SIZE,
+                            24,
+                            EGL_STENCIL_SIZE,
+                            8,
+                            EGL_RENDERABLE_TYPE,
+                            renderableTypeBit,
+                            EGL_NONE};
+    EGLint num_config;
+    if (!eglChooseConfig(DISPLAY, attrib_list, &cache.config, 1, &num_config) ||
+        num_config != 1) {
+      errorMessage = "Error choosing EGL config.";
+      state = GLCONTEXT_STATE_ERROR;
+      return;
+    }
   }
+  config = cache.config;
 
   // Create context
   EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION,
@@ -258,15 +358,21 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
                              EGL_ROBUST_RESOURCE_INITIALIZATION_ANGLE,
                              EGL_TRUE,
                              EGL_NONE};
-  context = eglCreateContext(DISPLAY, config, EGL_NO_CONTEXT, contextAttribs);
+  if (shareContext && shareContext->state != GLCONTEXT_STATE_OK) {
+    errorMessage = "Can't share objects with a destroyed context.";
+    state = GLCONTEXT_STATE_ERROR;
+    return;
+  }
+  context = eglCreateContext(DISPLAY, config, shareContext ? shareContext->context : EGL_NO_CONTEXT,
+                             contextAttribs);
   if (context == EGL_NO_CONTEXT) {
     state = GLCONTEXT_STATE_ERROR;
     return;
   }
+  shareGroup = shareContext ? shareContext->shareGroup : std::make_shared<ShareGroup>();
 
-  EGLint surfaceAttribs[] = {EGL_WIDTH, (EGLint)width, EGL_HEIGHT, (EGLint)height, EGL_NONE};
-  surface = eglCreatePbufferSurface(DISPLAY, config, surfaceAttribs);
-  if (surface == EGL_NO_SURFACE) {
+  surface = SURFACELESS ? EGL_NO_SURFACE : SharedSurface(config);
+  if (!SURFACELESS && surface == EGL_NO_SURFACE) {
     errorMessage = "Error creating EGL surface.";
     state = GLCONTEXT_STATE_ERROR;
     return;
@@ -284,7 +390,12 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
   registerContext();
   ACTIVE = this;
 
-  LoadGLES(eglGetProcAddress);
+  // The entry points are the same for every context, so they are only
+  // resolved once
+  if (!GLES_LOADED) {
+    LoadGLES(eglGetProcAddress);
+    GLES_LOADED = true;
+  }
 
   // Enable the debug callback to debug GL errors.
   // EnableDebugCallback(nullptr);
@@ -296,52 +407,48 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
   // std::cout << "ANGLE GL_VERSION: " << versionString << std::endl;
 
   // Check extensions
-  const char *extensionsString = (const char *)(glGetString(GL_EXTENSIONS));
-  enabledExtensions = GetStringSetFromCString(extensionsString);
+  if (!cache.ready) {
+    const char *extensionsString = (const char *)(glGetString(GL_EXTENSIONS));
+    cache.enabledExtensions = GetStringSetFromCString(extensionsString);
+
+    const char *requestableExtensionsString =
+        (const char *)glGetString(GL_REQUESTABLE_EXTENSIONS_ANGLE);
+    cache.requestableExtensions = std::make_shared<const std::set<std::string>>(
+        GetStringSetFromCString(requestableExtensionsString));
+
+    // Select best preferred depth
+    cache.preferredDepth = GL_DEPTH_COMPONENT16;
+    if (strstr(extensionsString, "GL_OES_depth32")) {
+      cache.preferredDepth = GL_DEPTH_COMPONENT32_OES;
+    } else if (strstr(extensionsString, "GL_OES_depth24")) {
+      cache.preferredDepth = GL_DEPTH_COMPONENT24_OES;
+    }
 
-  const char *requestableExtensionsString =
-      (const char *)glGetString(GL_REQUESTABLE_EXTENSIONS_ANGLE);
-  requestableExtensions = GetStringSetFromCString(requestableExtensionsString);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &cache.maxTextureSize);
+    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &cache.maxTextureUnits);
+  }
+  enabledExtensions = cache.enabledExtensions;
+  requestableExtensions = cache.requestableExtensions;
+  preferredDepth = cache.preferredDepth;
+  maxTextureSize = cache.maxTextureSize;
+  textureUnits2D.assign(cache.maxTextureUnits, 0);
 
   // Request necessary WebGL extensions.
   glRequestExtensionANGLE("GL_EXT_texture_storage");
 
-  // Select best preferred depth
-  preferredDepth = GL_DEPTH_COMPONENT16;
-  if (strstr(extensionsString, "GL_OES_depth32")) {
-    preferredDepth = GL_DEPTH_COMPONENT32_OES;
-  } else if (strstr(extensionsString, "GL_OES_depth24")) {
-    preferredDepth = GL_DEPTH_COMPONENT24_OES;
-  }
-
-  // Each WebGL extension maps to one or more required ANGLE extensions.
-  webGLToANGLEExtensions.insert({"STACKGL_destroy_context", {}});
-  webGLToANGLEExtensions.insert({"STACKGL_resize_drawingbuffer", {}});
-  webGLToANGLEExtensions.insert(
-      {"EXT_texture_filter_anisotropic", {"GL_EXT_texture_filter_anisotropic"}});
-  webGLToANGLEExtensions.insert({"OES_texture_float_linear", {"GL_OES_texture_float_linear"}});
-  if (createWebGL2Context) {
-    webGLToANGLEExtensions.insert({"EXT_color_buffer_float", {"GL_EXT_color_buffer_float"}});
-  } else {
-    webGLToANGLEExtensions.insert({"ANGLE_instanced_arrays", {"GL_ANGLE_instanced_arrays"}});
-    webGLToANGLEExtensions.insert({"OES_element_index_uint", {"GL_OES_element_index_uint"}});
-    webGLToANGLEExtensions.insert({"EXT_blend_minmax", {"GL_EXT_blend_minmax"}});
-    webGLToANGLEExtensions.insert({"OES_standard_derivatives", {"GL_OES_standard_derivatives"}});
-    webGLToANGLEExtensions.insert({"OES_texture_float",
-                                   {"GL_OES_texture_float", "GL_CHROMIUM_color_buffer_float_rgba",
-                                    "GL_CHROMIUM_color_buffer_float_rgb"}});
-    webGLToANGLEExtensions.insert({"WEBGL_draw_buffers", {"GL_EXT_draw_buffers"}});
-    webGLToANGLEExtensions.insert({"OES_vertex_array_object", {"GL_OES_vertex_array_object"}});
-    webGLToANGLEExtensions.insert({"EXT_shader_texture_lod", {"GL_EXT_shader_texture_lod"}});
-  }
-
-  for (const auto &iter : webGLToANGLEExtensions) {
-    const std::string &webGLExtension = iter.first;
-    const std::vector<std::string> &angleExtensions = iter.second;
-    if (ContextSupportsExtensions(this, angleExtensions)) {
-      supportedWebGLExtensions.insert(webGLExtension);
+  if (!cache.ready) {
+    auto supported = std::make_shared<std::set<std::string>>();
+    for (const auto &iter : *webGLToANGLEExtensions) {
+      const std::string &webGLExtension = iter.first;
+      const std::vector<std::string> &angleExtensions = iter.second;
+      if (ContextSupportsExtensions(this, angleExtensions)) {
+        supported->insert(webGLExtension);
+      }
     }
+    cache.supportedWebGLExtensions = supported;
+    cache.ready = true;
   }
+  supportedWebGLExtensions = cache.supportedWebGLExtensions;
 }
 
 bool WebGLRenderingContext::setActive() {
@@ -351,6 +458,11 @@ bool WebGLRenderingContext::setActive() {
   if (this == ACTIVE) {
     return true;
   }
+  // Changes made to shared objects are only guaranteed to be seen by the
+  // other contexts in the share group once they have been flushed
+  if (ACTIVE && ACTIVE->shareGroup == shareGroup) {
+    glFlush();
+  }
   if (!eglMakeCurrent(DISPLAY, surface, surface, context)) {
     state = GLCONTEXT_STATE_ERROR;
     return false;
@@ -366,62 +478,273 @@ void WebGLRenderingContext::setError(GLenum error) {
   errorSet.insert(error);
 }
 
+// Deletes the names of one type with a single call where GL takes an array,
+// which is much cheaper than one call per object when a context full of them
+// is torn down.
+void WebGLRenderingContext::DeleteGLObjects(GLObjectType type,
+                                            const std::vector<GLuint> &names) {
+  if (names.empty()) {
+    return;
+  }
+  GLsizei count = static_cast<GLsizei>(names.size());
+  switch (type) {
+  case GLOBJECT_TYPE_PROGRAM:
+    for (GLuint name : names) {
+      glDeleteProgram(name);
+    }
+    break;
+  case GLOBJECT_TYPE_BUFFER:
+    glDeleteBuffers(count, names.data());
+    break;
+  case GLOBJECT_TYPE_FRAMEBUFFER:
+    glDeleteFramebuffers(count, names.data());
+    break;
+  case GLOBJECT_TYPE_RENDERBUFFER:
+    glDeleteRenderbuffers(count, names.data());
+    break;
+  case GLOBJECT_TYPE_SHADER:
+    for (GLuint name : names) {
+      glDeleteShader(name);
+    }
+    break;
+  case GLOBJECT_TYPE_TEXTURE:
+    glDeleteTextures(count, names.data());
+    break;
+  case GLOBJECT_TYPE_VERTEX_ARRAY:
+    glDeleteVertexArraysOES(count, names.data());
+    break;
+  default:
+    break;
+  }
+}
+
+void WebGLRenderingContext::DeleteGLObjects(const GLObjectRegistry &objects) {
+  // Framebuffers and vertex arrays first, since they refer to the others
+  for (GLObjectType type : {GLOBJECT_TYPE_FRAMEBUFFER, GLOBJECT_TYPE_VERTEX_ARRAY,
+                            GLOBJECT_TYPE_PROGRAM, GLOBJECT_TYPE_SHADER,
+                            GLOBJECT_TYPE_RENDERBUFFER, GLOBJECT_TYPE_TEXTURE,
+                            GLOBJECT_TYPE_BUFFER}) {
+    DeleteGLObjects(type, objects[type].names());
+  }
+}
+
+// V8 only sees the wrappers of GL objects, so the memory behind them is
+// reported as external memory. Garbage collections then keep up with an
+// application that drops wrappers of large textures and buffers.
+static void ReportExternalMemory(int64_t change) {
+  while (change != 0) {
+    int64_t step = std::max<int64_t>(INT_MIN, std::min<int64_t>(INT_MAX, change));
+    Nan::AdjustExternalMemory(static_cast<int>(step));
+    change -= step;
+  }
+}
+
+void WebGLRenderingContext::ShareGroup::adjustBytes(size_t removed, size_t added) {
+  bytes = bytes - removed + added;
+  ReportExternalMemory(static_cast<int64_t>(added) - static_cast<int64_t>(removed));
+}
+
+// The objects are deleted along with the last context of the group
+WebGLRenderingContext::ShareGroup::~ShareGroup() {
+  ReportExternalMemory(-static_cast<int64_t>(bytes));
+}
+
+void WebGLRenderingContext::unregisterGLObj(GLObjectType type, GLuint obj) {
+  GLObjectSet &list = objectsOfType(type);
+  GLObjectInfo *object = list.find(obj);
+  if (object) {
+    shareGroup->adjustBytes(object->bytes, 0);
+    list.erase(obj);
+  }
+  if (type == GLOBJECT_TYPE_TEXTURE) {
+    shareGroup->promotedMipChains.erase(obj);
+  }
+}
+
+GLuint WebGLRenderingContext::boundObject(GLenum target) {
+  GLenum binding;
+  switch (target) {
+  case GL_ARRAY_BUFFER:
+    binding = GL_ARRAY_BUFFER_BINDING;
+    break;
+  case GL_ELEMENT_ARRAY_BUFFER:
+    binding = GL_ELEMENT_ARRAY_BUFFER_BINDING;
+    break;
+  case GL_COPY_READ_BUFFER:
+    binding = GL_COPY_READ_BUFFER_BINDING;
+    break;
+  case GL_COPY_WRITE_BUFFER:
+    binding = GL_COPY_WRITE_BUFFER_BINDING;
+    break;
+  case GL_PIXEL_PACK_BUFFER:
+    binding = GL_PIXEL_PACK_BUFFER_BINDING;
+    break;
+  case GL_PIXEL_UNPACK_BUFFER:
+    binding = GL_PIXEL_UNPACK_BUFFER_BINDING;
+    break;
+  case GL_TRANSFORM_FEEDBACK_BUFFER:
+    binding = GL_TRANSFORM_FEEDBACK_BUFFER_BINDING;
+    break;
+  case GL_UNIFORM_BUFFER:
+    binding = GL_UNIFORM_BUFFER_BINDING;
+    break;
+  case GL_TEXTURE_2D:
+    binding = GL_TEXTURE_BINDING_2D;
+    break;
+  case GL_TEXTURE_CUBE_MAP:
+  case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+  case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+  case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+  case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+  case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+  case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+    binding = GL_TEXTURE_BINDING_CUBE_MAP;
+    break;
+  case GL_TEXTURE_3D:
+    binding = GL_TEXTURE_BINDING_3D;
+    break;
+  case GL_TEXTURE_2D_ARRAY:
+    binding = GL_TEXTURE_BINDING_2D_ARRAY;
+    break;
+  case GL_RENDERBUFFER:
+    binding = GL_RENDERBUFFER_BINDING;
+    break;
+  default:
+    return 0;
+  }
+  GLint name = 0;
+  glGetIntegerv(binding, &name);
+  return static_cast<GLuint>(name);
+}
+
+// Returns false and raises OUT_OF_MEMORY if giving one image of an object the
+// given size would go over the limit. Objects that aren't known, such as the
+// name 0, are left for GL to reject.
+bool WebGLRenderingContext::checkAllocation(GLObjectType type, GLuint name,
+                                            std::pair<GLenum, GLint> image, size_t bytes) {
+  GLObjectInfo *object = shareGroup->objects[type].find(name);
+  if (!object || memoryLimit <= 0) {
+    return true;
+  }
+  auto previous = object->images.find(image);
+  size_t previousBytes = previous == object->images.end() ? 0 : previous->second;
+  if (bytes > previousBytes &&
+      static_cast<double>(shareGroup->bytes - previousBytes + bytes) > memoryLimit) {
+    setError(GL_OUT_OF_MEMORY);
+    return false;
+  }
+  return true;
+}
+
+// Like checkAllocation, for storage that replaces everything the object held
+bool WebGLRenderingContext::checkStorage(GLObjectType type, GLuint name, size_t bytes) {
+  GLObjectInfo *object = shareGroup->objects[type].find(name);
+  if (!object || memoryLimit <= 0) {
+    return true;
+  }
+  if (bytes > object->bytes &&
+      static_cast<double>(shareGroup->bytes - object->bytes + bytes) > memoryLimit) {
+    setError(GL_OUT_OF_MEMORY);
+    return false;
+  }
+  return true;
+}
+
+// Records the size of one image of an object
+void WebGLRenderingContext::trackAllocation(GLObjectType type, GLuint name,
+                                            std::pair<GLenum, GLint> image, size_t bytes) {
+  GLObjectInfo *object = shareGroup->objects[type].find(name);
+  if (!object) {
+    return;
+  }
+  auto previous = object->images.find(image);
+  size_t previousBytes = previous == object->images.end() ? 0 : previous->second;
+  object->images[image] = bytes;
+  object->bytes = object->bytes - previousBytes + bytes;
+  shareGroup->adjustBytes(previousBytes, bytes);
+}
+
+// Like trackAllocation, for storage that replaces everything the object held
+void WebGLRenderingContext::trackStorage(GLObjectType type, GLuint name, size_t bytes) {
+  GLObjectInfo *object = shareGroup->objects[type].find(name);
+  if (!object) {
+    return;
+  }
+  object->images.clear();
+  shareGroup->adjustBytes(object->bytes, bytes);
+  object->bytes = bytes;
+}
+
+// Hands the errors GL has raised so far to the application, so that
+// glCallSucceeded only sees those of the call that follows
+void WebGLRenderingContext::flushGLErrors() {
+  glCallSucceeded();
+}
+
+// Returns whether the GL calls since the last flush raised no error. Errors
+// are kept for the application's getError.
+bool WebGLRenderingContext::glCallSucceeded() {
+  bool succeeded = true;
+  for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+    setError(error);
+    succeeded = false;
+  }
+  return succeeded;
+}
+
 void WebGLRenderingContext::dispose() {
   // Unregister context
   unregisterContext();
 
   if (!setActive()) {
     state = GLCONTEXT_STATE_ERROR;
+    shareGroup.reset();
     return;
   }
 
   // Update state
   state = GLCONTEXT_STATE_DESTROY;
 
-  // Destroy all object references
-  for (std::map<std::pair<GLuint, GLObjectType>, bool>::iterator iter = objects.begin();
-       iter != objects.end(); ++iter) {
-
-    GLuint obj = iter->first.first;
+  // Recorded mip chains are never uploaded once the context goes away
+  pendingMipChains.clear();
 
-    switch (iter->first.second) {
-    case GLOBJECT_TYPE_PROGRAM:
-      glDeleteProgram(obj);
-      break;
-    case GLOBJECT_TYPE_BUFFER:
-      glDeleteBuffers(1, &obj);
-      break;
-    case GLOBJECT_TYPE_FRAMEBUFFER:
-      glDeleteFramebuffers(1, &obj);
-      break;
-    case GLOBJECT_TYPE_RENDERBUFFER:
-      glDeleteRenderbuffers(1, &obj);
-      break;
-    case GLOBJECT_TYPE_SHADER:
-      glDeleteShader(obj);
-      break;
-    case GLOBJECT_TYPE_TEXTURE:
-      glDeleteTextures(1, &obj);
-      break;
-    case GLOBJECT_TYPE_VERTEX_ARRAY:
-      glDeleteVertexArraysOES(1, &obj);
-      break;
-    default:
-      break;
-    }
+  // Destroy all object references, and the shared ones if no other context
+  // can still use them
+  DeleteGLObjects(objects);
+  objects.clear();
+  if (shareGroup.use_count() == 1) {
+    DeleteGLObjects(shareGroup->objects);
   }
+  shareGroup.reset();
 
   // Deactivate context
   eglMakeCurrent(DISPLAY, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
   ACTIVE = NULL;
 
-  // Destroy surface and context
-
-  // FIXME:  This shouldn't be commented out
-  // eglDestroySurface(DISPLAY, surface);
+  // Destroy context, the surface is shared
   eglDestroyContext(DISPLAY, context);
 }
 
+EGLSurface WebGLRenderingContext::SharedSurface(EGLConfig config) {
+  auto iter = SHARED_SURFACES.find(config);
+  if (iter != SHARED_SURFACES.end()) {
+    return iter->second;
+  }
+  EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+  EGLSurface surface = eglCreatePbufferSurface(DISPLAY, config, surfaceAttribs);
+  if (surface != EGL_NO_SURFACE) {
+    SHARED_SURFACES[config] = surface;
+  }
+  return surface;
+}
+
+void WebGLRenderingContext::DestroySharedSurfaces() {
+  for (const auto &iter : SHARED_SURFACES) {
+    eglDestroySurface(DISPLAY, iter.second);
+  }
+  SHARED_SURFACES.clear();
+}
+
 WebGLRenderingContext::~WebGLRenderingContext() { dispose(); }
 
 GL_METHOD(SetError) {
@@ -429,6 +752,21 @@ GL_METHOD(SetError) {
   inst->setError((GLenum)(Nan::To<int32_t>(info[0]).ToChecked()));
 }
 
+GL_METHOD(GetPixelFormatSize) {
+  GLenum format = Nan::To<int32_t>(info[0]).ToChecked();
+  GLenum type = Nan::To<int32_t>(info[1]).ToChecked();
+
+  info.GetReturnValue().Set(
+      Nan::New<v8::Integer>(static_cast<uint32_t>(PixelFormatSize(format, type))));
+}
+
+GL_METHOD(ValidateShaderSource) {
+  Nan::Utf8String source(info[0]);
+
+  info.GetReturnValue().Set(
+      Nan::New<v8::Boolean>(IsValidShaderSource(*source, static_cast<size_t>(source.length()))));
+}
+
 GL_METHOD(DisposeAll) {
   Nan::HandleScope();
 
@@ -437,6 +775,10 @@ GL_METHOD(DisposeAll) {
   }
 
   if (WebGLRenderingContext::HAS_DISPLAY) {
+    WebGLRenderingContext::DestroySharedSurfaces();
+    for (WebGLRenderingContext::DisplayCache &cache : WebGLRenderingContext::DISPLAY_CACHES) {
+      cache = WebGLRenderingContext::DisplayCache();
+    }
     eglTerminate(WebGLRenderingContext::DISPLAY);
     WebGLRenderingContext::HAS_DISPLAY = false;
   }
@@ -446,6 +788,22 @@ GL_METHOD(New) {
   Nan::HandleScope();
 
   bool createWebGL2Context = Nan::To<bool>(info[10]).ToChecked();
+  bool promoteTextureStorage = Nan::To<bool>(info[11]).ToChecked();
+  std::string programCacheDir;
+  if (info[12]->IsString()) {
+    programCacheDir = *Nan::Utf8String(info[12]);
+  }
+  double programCacheMaxBytes = Nan::To<double>(info[13]).FromMaybe(0);
+  double programCacheMemoryBytes = Nan::To<double>(info[14]).FromMaybe(0);
+  double memoryLimit = Nan::To<double>(info[16]).FromMaybe(0);
+  WebGLRenderingContext *shareContext = NULL;
+  if (info[15]->IsObject()) {
+    v8::Local<v8::Object> other = info[15].As<v8::Object>();
+    if (other->InternalFieldCount() <= 0) {
+      return Nan::ThrowTypeError("shareWith must be a WebGL context");
+    }
+    shareContext = node::ObjectWrap::Unwrap<WebGLRenderingContext>(other);
+  }
 
   WebGLRenderingContext *instance =
       new WebGLRenderingContext(Nan::To<int32_t>(info[0]).ToChecked(), // Width
@@ -458,7 +816,9 @@ GL_METHOD(New) {
                                 Nan::To<bool>(info[7]).ToChecked(),    // preserve drawing buffer
                                 Nan::To<bool>(info[8]).ToChecked(),    // low power
                                 Nan::To<bool>(info[9]).ToChecked(),    // fail if crap
-                                createWebGL2Context);
+                                createWebGL2Context, promoteTextureStorage, programCacheDir,
+                                programCacheMaxBytes, programCacheMemoryBytes, shareContext,
+                                memoryLimit);
 
   if (instance->state != GLCONTEXT_STATE_OK) {
     if (!instance->errorMessage.empty()) {
@@ -484,6 +844,240 @@ GL_METHOD(Destroy) {
   inst->dispose();
 }
 
+void WebGLRenderingContext::resetState(const std::set<GLObjectReference> &keep) {
+  // Shared objects can only go if no other context is using them
+  GLObjectRegistry dropped;
+  for (GLObjectRegistry *registry : {&objects, &shareGroup->objects}) {
+    if (registry == &shareGroup->objects && shareGroup.use_count() > 1) {
+      continue;
+    }
+    for (int t = 0; t < GLOBJECT_TYPE_COUNT; ++t) {
+      GLObjectType type = static_cast<GLObjectType>(t);
+      GLObjectSet &list = (*registry)[type];
+      for (size_t i = list.size(); i-- > 0;) {
+        GLuint name = list.names()[i];
+        if (!keep.count(std::make_pair(name, type))) {
+          shareGroup->adjustBytes(list.infoAt(i).bytes, 0);
+          dropped[type].insert(name);
+          list.erase(name);
+          if (type == GLOBJECT_TYPE_TEXTURE) {
+            shareGroup->promotedMipChains.erase(name);
+          }
+        }
+      }
+    }
+  }
+
+  // Unbind everything before deleting, so nothing is kept alive by a binding
+  GLint maxAttribs = 0;
+  GLint maxTextureUnits = 0;
+  glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttribs);
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+  glUseProgram(0);
+  if (webgl2) {
+    glBindVertexArray(0);
+  } else {
+    glBindVertexArrayOES(0);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  for (GLint i = 0; i < maxTextureUnits; ++i) {
+    glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    if (webgl2) {
+      glBindTexture(GL_TEXTURE_3D, 0);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+      glBindSampler(i, 0);
+    }
+  }
+  glActiveTexture(GL_TEXTURE0);
+  for (GLint i = 0; i < maxAttribs; ++i) {
+    glDisableVertexAttribArray(i);
+    glVertexAttrib4f(i, 0, 0, 0, 1);
+    if (webgl2) {
+      glVertexAttribDivisor(i, 0);
+    } else {
+      glVertexAttribDivisorANGLE(i, 0);
+    }
+  }
+  if (webgl2) {
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  DeleteGLObjects(dropped);
+
+  // Fixed function state
+  for (GLenum cap : {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_POLYGON_OFFSET_FILL,
+                     GL_SAMPLE_ALPHA_TO_COVERAGE, GL_SAMPLE_COVERAGE, GL_SCISSOR_TEST,
+                     GL_STENCIL_TEST}) {
+    glDisable(cap);
+  }
+  glEnable(GL_DITHER);
+  if (webgl2) {
+    glDisable(GL_RASTERIZER_DISCARD);
+  }
+  glBlendColor(0, 0, 0, 0);
+  glBlendEquation(GL_FUNC_ADD);
+  glBlendFunc(GL_ONE, GL_ZERO);
+  glClearColor(0, 0, 0, 0);
+  glClearDepthf(1);
+  glClearStencil(0);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glCullFace(GL_BACK);
+  glDepthFunc(GL_LESS);
+  glDepthMask(GL_TRUE);
+  glDepthRangef(0, 1);
+  glFrontFace(GL_CCW);
+  glHint(GL_GENERATE_MIPMAP_HINT, GL_DONT_CARE);
+  glLineWidth(1);
+  glPolygonOffset(0, 0);
+  glSampleCoverage(1, GL_FALSE);
+  glStencilFunc(GL_ALWAYS, 0, ~0u);
+  glStencilMask(~0u);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+  // Pixel storage
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  if (webgl2) {
+    for (GLenum pname : {GL_PACK_ROW_LENGTH, GL_PACK_SKIP_ROWS, GL_PACK_SKIP_PIXELS,
+                         GL_UNPACK_ROW_LENGTH, GL_UNPACK_IMAGE_HEIGHT, GL_UNPACK_SKIP_ROWS,
+                         GL_UNPACK_SKIP_PIXELS, GL_UNPACK_SKIP_IMAGES}) {
+      glPixelStorei(pname, 0);
+    }
+  }
+  unpack_flip_y = false;
+  unpack_premultiply_alpha = false;
+  unpack_colorspace_conversion = 0x9244;
+  unpack_alignment = 4;
+
+  pendingMipChains.clear();
+  sampledMipChains.clear();
+  std::fill(textureUnits2D.begin(), textureUnits2D.end(), 0);
+  activeTextureUnit = 0;
+  shaderStats = ShaderStats();
+
+  // Errors raised by the reset, such as divisors without ANGLE_instanced_arrays
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  errorSet.clear();
+}
+
+GL_METHOD(ResetState) {
+  GL_BOILERPLATE;
+
+  // Lists of buffers, framebuffers, renderbuffers, textures, programs and
+  // shaders to keep
+  static const GLObjectType types[] = {
+      GLOBJECT_TYPE_BUFFER,  GLOBJECT_TYPE_FRAMEBUFFER, GLOBJECT_TYPE_RENDERBUFFER,
+      GLOBJECT_TYPE_TEXTURE, GLOBJECT_TYPE_PROGRAM,     GLOBJECT_TYPE_SHADER};
+  std::set<GLObjectReference> keep;
+  for (int i = 0; i < 6; ++i) {
+    if (!info[i]->IsArray()) {
+      continue;
+    }
+    v8::Local<v8::Array> names = info[i].As<v8::Array>();
+    for (uint32_t j = 0; j < names->Length(); ++j) {
+      GLuint name = Nan::To<uint32_t>(Nan::Get(names, j).ToLocalChecked()).FromMaybe(0);
+      keep.insert(std::make_pair(name, types[i]));
+    }
+  }
+
+  inst->resetState(keep);
+}
+
+// Deletes a list of objects of one type, named by its KHR_debug identifier,
+// in a single GL call where GL takes an array. Names the context doesn't know
+// about, or has already deleted, are skipped.
+GL_METHOD(DeleteObjectsBatch) {
+  GL_BOILERPLATE;
+
+  GLObjectType type;
+  switch (Nan::To<uint32_t>(info[0]).FromMaybe(0)) {
+  case GL_BUFFER_KHR:
+    type = GLOBJECT_TYPE_BUFFER;
+    break;
+  case GL_FRAMEBUFFER:
+    type = GLOBJECT_TYPE_FRAMEBUFFER;
+    break;
+  case GL_PROGRAM_KHR:
+    type = GLOBJECT_TYPE_PROGRAM;
+    break;
+  case GL_RENDERBUFFER:
+    type = GLOBJECT_TYPE_RENDERBUFFER;
+    break;
+  case GL_SHADER_KHR:
+    type = GLOBJECT_TYPE_SHADER;
+    break;
+  case GL_TEXTURE:
+    type = GLOBJECT_TYPE_TEXTURE;
+    break;
+  case GL_VERTEX_ARRAY_KHR:
+    type = GLOBJECT_TYPE_VERTEX_ARRAY;
+    break;
+  default:
+    inst->setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (!info[1]->IsArray()) {
+    return;
+  }
+
+  v8::Local<v8::Array> ids = info[1].As<v8::Array>();
+  GLObjectSet &list = inst->objectsOfType(type);
+  std::vector<GLuint> names;
+  names.reserve(ids->Length());
+  for (uint32_t i = 0; i < ids->Length(); ++i) {
+    GLuint name = Nan::To<uint32_t>(Nan::Get(ids, i).ToLocalChecked()).FromMaybe(0);
+    if (!list.contains(name)) {
+      continue;
+    }
+    inst->unregisterGLObj(type, name);
+    if (type == GLOBJECT_TYPE_TEXTURE) {
+      inst->pendingMipChains.erase(name);
+    } else if (type == GLOBJECT_TYPE_PROGRAM) {
+      inst->shaderStats.deleteProgram(name);
+    } else if (type == GLOBJECT_TYPE_SHADER) {
+      inst->shaderStats.deleteShader(name);
+    }
+    names.push_back(name);
+  }
+  WebGLRenderingContext::DeleteGLObjects(type, names);
+}
+
+// Releases memory that is only kept to make later calls faster: the staging
+// buffer of texSubImage3DLayers and the shader compiler. The drawing buffer
+// is left alone, since the application can read it back at any time. Returns
+// an estimate of the bytes released.
+GL_METHOD(TrimMemory) {
+  GL_BOILERPLATE;
+
+  double released = static_cast<double>(inst->layerStaging.capacity());
+  std::vector<uint8_t>().swap(inst->layerStaging);
+  glReleaseShaderCompiler();
+
+  info.GetReturnValue().Set(Nan::New<v8::Number>(released));
+}
+
+// Drops the program caches kept in memory, which every context of the
+// process shares. Entries in a programCache directory stay. Returns an
+// estimate of the bytes released.
+GL_METHOD(TrimProgramCache) {
+  double released = ProgramCache::TrimMemory();
+  if (HAS_DISPLAY && PROGRAM_CACHE_CONTROL) {
+    released += eglProgramCacheResizeANGLE(DISPLAY, 0, EGL_PROGRAM_CACHE_TRIM_ANGLE);
+  }
+
+  info.GetReturnValue().Set(Nan::New<v8::Number>(released));
+}
+
 GL_METHOD(Uniform1f) {
   GL_BOILERPLATE;
 
@@ -638,6 +1232,29 @@ GL_METHOD(VertexAttribDivisorANGLE) {
   glVertexAttribDivisorANGLE(index, divisor);
 }
 
+GL_METHOD(MaxShaderCompilerThreadsKHR) {
+  GL_BOILERPLATE;
+
+  glMaxShaderCompilerThreadsKHR(Nan::To<uint32_t>(info[0]).ToChecked());
+}
+
+// Enables GL_KHR_parallel_shader_compile for linkProgramAsync without
+// exposing the WebGL extension to the application. Returns whether
+// completion can be polled.
+GL_METHOD(EnableParallelShaderCompile) {
+  GL_BOILERPLATE;
+
+  bool enabled = inst->enabledExtensions.count("GL_KHR_parallel_shader_compile") != 0;
+  if (!enabled && inst->supportedWebGLExtensions->count("KHR_parallel_shader_compile") != 0 &&
+      inst->requestableExtensions->count("GL_KHR_parallel_shader_compile") != 0) {
+    glRequestExtensionANGLE("GL_KHR_parallel_shader_compile");
+    inst->enabledExtensions.insert("GL_KHR_parallel_shader_compile");
+    enabled = true;
+  }
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(enabled));
+}
+
 GL_METHOD(DrawArraysInstancedANGLE) {
   GL_BOILERPLATE;
 
@@ -646,6 +1263,7 @@ GL_METHOD(DrawArraysInstancedANGLE) {
   GLuint count = Nan::To<uint32_t>(info[2]).ToChecked();
   GLuint icount = Nan::To<uint32_t>(info[3]).ToChecked();
 
+  inst->demoteSampledMipChains();
   glDrawArraysInstancedANGLE(mode, first, count, icount);
 }
 
@@ -658,6 +1276,7 @@ GL_METHOD(DrawElementsInstancedANGLE) {
   GLint offset = Nan::To<int32_t>(info[3]).ToChecked();
   GLuint icount = Nan::To<uint32_t>(info[4]).ToChecked();
 
+  inst->demoteSampledMipChains();
   glDrawElementsInstancedANGLE(mode, count, type,
                                reinterpret_cast<GLvoid *>(static_cast<uintptr_t>(offset)), icount);
 }
@@ -669,6 +1288,7 @@ GL_METHOD(DrawArrays) {
   GLint first = Nan::To<int32_t>(info[1]).ToChecked();
   GLint count = Nan::To<int32_t>(info[2]).ToChecked();
 
+  inst->demoteSampledMipChains();
   glDrawArrays(mode, first, count);
 }
 
@@ -706,6 +1326,16 @@ GL_METHOD(GenerateMipmap) {
   GL_BOILERPLATE;
 
   GLint target = Nan::To<int32_t>(info[0]).ToChecked();
+
+  // A recorded chain only needs its first level to be completed by the driver.
+  if (target == GL_TEXTURE_2D && !inst->pendingMipChains.empty()) {
+    GLuint texture = inst->boundTexture2D();
+    if (inst->pendingMipChains.count(texture)) {
+      inst->promoteMipChain(texture, true);
+      return;
+    }
+  }
+
   glGenerateMipmap(target);
 }
 
@@ -751,17 +1381,26 @@ GL_METHOD(ShaderSource) {
 
   GLint id = Nan::To<int32_t>(info[0]).ToChecked();
   Nan::Utf8String code(info[1]);
+  // The wrapper knows the type, which saves asking GL for it
+  GLenum type = Nan::To<uint32_t>(info[2]).FromMaybe(0);
 
   const char *codes[] = {*code};
   GLint length = code.length();
 
   glShaderSource(id, 1, codes, &length);
+
+  inst->shaderStats.shaderSource(id, type, *code, code.length());
 }
 
 GL_METHOD(CompileShader) {
   GL_BOILERPLATE;
 
-  glCompileShader(Nan::To<int32_t>(info[0]).ToChecked());
+  GLuint shader = Nan::To<int32_t>(info[0]).ToChecked();
+
+  ProgramCache::Timer timer(ProgramCache::COMPILE);
+  double start = ShaderStats::Now();
+  glCompileShader(shader);
+  inst->shaderStats.compileStarted(shader, ShaderStats::Now() - start);
 }
 
 GL_METHOD(FrontFace) {
@@ -777,7 +1416,14 @@ GL_METHOD(GetShaderParameter) {
   GLenum pname = Nan::To<int32_t>(info[1]).ToChecked();
 
   GLint value;
-  glGetShaderiv(shader, pname, &value);
+  if (pname == GL_COMPILE_STATUS && inst->shaderStats.compilePending(shader)) {
+    // The first status query waits for the compiler to finish
+    double start = ShaderStats::Now();
+    glGetShaderiv(shader, pname, &value);
+    inst->shaderStats.compileResolved(shader, ShaderStats::Now() - start);
+  } else {
+    glGetShaderiv(shader, pname, &value);
+  }
 
   info.GetReturnValue().Set(Nan::New<v8::Integer>(value));
 }
@@ -825,221 +1471,1345 @@ GL_METHOD(ValidateProgram) {
 GL_METHOD(LinkProgram) {
   GL_BOILERPLATE;
 
-  glLinkProgram(Nan::To<int32_t>(info[0]).ToChecked());
+  GLuint program = Nan::To<int32_t>(info[0]).ToChecked();
+
+  ProgramCache::Timer timer(ProgramCache::LINK);
+  double start = ShaderStats::Now();
+  glLinkProgram(program);
+  inst->shaderStats.linkStarted(program, ShaderStats::Now() - start);
+}
+
+v8::Local<v8::Object> NewActiveInfo(const char *name, GLint size, GLenum type) {
+  v8::Local<v8::Object> activeInfo = Nan::New<v8::Object>();
+  Nan::Set(activeInfo, Nan::New<v8::String>("size").ToLocalChecked(),
+           Nan::New<v8::Integer>(size));
+  Nan::Set(activeInfo, Nan::New<v8::String>("type").ToLocalChecked(),
+           Nan::New<v8::Integer>(type));
+  Nan::Set(activeInfo, Nan::New<v8::String>("name").ToLocalChecked(),
+           Nan::New<v8::String>(name).ToLocalChecked());
+  return activeInfo;
+}
+
+// Reads back everything the wrapper records about a linked program in one
+// call: the link status and log, active attributes and uniforms with their
+// locations (every element's, for arrays) and, on WebGL 2, uniform blocks.
+//
+// Attributes are bound to the locations the linker picked, so relinking the
+// program later keeps them where they are without relinking it now.
+v8::Local<v8::Object> WebGLRenderingContext::reflectProgram(GLuint program) {
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+
+  GLint linkStatus = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+  Nan::Set(result, Nan::New<v8::String>("linkStatus").ToLocalChecked(),
+           Nan::New<v8::Boolean>(linkStatus == GL_TRUE));
+
+  if (linkStatus != GL_TRUE) {
+    GLint infoLogLength = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogLength);
+    std::vector<char> infoLog(infoLogLength + 1, '\0');
+    glGetProgramInfoLog(program, infoLog.size(), nullptr, infoLog.data());
+    Nan::Set(result, Nan::New<v8::String>("infoLog").ToLocalChecked(),
+             Nan::New<v8::String>(infoLog.data()).ToLocalChecked());
+    return result;
+  }
+
+  GLint attributeMaxLength = 0;
+  GLint uniformMaxLength = 0;
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &attributeMaxLength);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniformMaxLength);
+  GLint maxLength = std::max(attributeMaxLength, uniformMaxLength);
+  if (webgl2) {
+    GLint blockMaxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &blockMaxLength);
+    maxLength = std::max(maxLength, blockMaxLength);
+  }
+  std::vector<char> name(maxLength + 1, '\0');
+
+  GLint attributeCount = 0;
+  glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+  v8::Local<v8::Array> attributes = Nan::New<v8::Array>(attributeCount);
+  for (GLint i = 0; i < attributeCount; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveAttrib(program, i, name.size(), &length, &size, &type, name.data());
+    name[length] = '\0';
+    GLint location = glGetAttribLocation(program, name.data());
+    if (location >= 0) {
+      glBindAttribLocation(program, location, name.data());
+    }
+    v8::Local<v8::Object> attribute = NewActiveInfo(name.data(), size, type);
+    Nan::Set(attribute, Nan::New<v8::String>("location").ToLocalChecked(),
+             Nan::New<v8::Integer>(location));
+    Nan::Set(attributes, i, attribute);
+  }
+  Nan::Set(result, Nan::New<v8::String>("attributes").ToLocalChecked(), attributes);
+
+  GLint uniformCount = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+  v8::Local<v8::Array> uniforms = Nan::New<v8::Array>(uniformCount);
+  for (GLint i = 0; i < uniformCount; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(program, i, name.size(), &length, &size, &type, name.data());
+    name[length] = '\0';
+    v8::Local<v8::Object> uniform = NewActiveInfo(name.data(), size, type);
+    Nan::Set(uniform, Nan::New<v8::String>("location").ToLocalChecked(),
+             Nan::New<v8::Integer>(glGetUniformLocation(program, name.data())));
+
+    // Arrays are reported by their first element, so look up the rest
+    std::string baseName(name.data(), length);
+    if (baseName.size() > 3 && baseName.compare(baseName.size() - 3, 3, "[0]") == 0) {
+      baseName.resize(baseName.size() - 3);
+      v8::Local<v8::Array> locations = Nan::New<v8::Array>(size);
+      for (GLint element = 0; element < size; ++element) {
+        std::string elementName = baseName + "[" + std::to_string(element) + "]";
+        Nan::Set(locations, element,
+                 Nan::New<v8::Integer>(glGetUniformLocation(program, elementName.c_str())));
+      }
+      Nan::Set(uniform, Nan::New<v8::String>("locations").ToLocalChecked(), locations);
+    }
+    Nan::Set(uniforms, i, uniform);
+  }
+  Nan::Set(result, Nan::New<v8::String>("uniforms").ToLocalChecked(), uniforms);
+
+  GLint blockCount = 0;
+  if (webgl2) {
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+  }
+  v8::Local<v8::Array> uniformBlocks = Nan::New<v8::Array>(blockCount);
+  for (GLint i = 0; i < blockCount; ++i) {
+    GLsizei length = 0;
+    GLint binding = 0;
+    GLint dataSize = 0;
+    GLint activeUniforms = 0;
+    glGetActiveUniformBlockName(program, i, name.size(), &length, name.data());
+    name[length] = '\0';
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &activeUniforms);
+
+    v8::Local<v8::Object> block = Nan::New<v8::Object>();
+    Nan::Set(block, Nan::New<v8::String>("name").ToLocalChecked(),
+             Nan::New<v8::String>(name.data()).ToLocalChecked());
+    Nan::Set(block, Nan::New<v8::String>("binding").ToLocalChecked(),
+             Nan::New<v8::Integer>(binding));
+    Nan::Set(block, Nan::New<v8::String>("dataSize").ToLocalChecked(),
+             Nan::New<v8::Integer>(dataSize));
+    Nan::Set(block, Nan::New<v8::String>("activeUniforms").ToLocalChecked(),
+             Nan::New<v8::Integer>(activeUniforms));
+    Nan::Set(uniformBlocks, i, block);
+  }
+  Nan::Set(result, Nan::New<v8::String>("uniformBlocks").ToLocalChecked(), uniformBlocks);
+
+  return result;
+}
+
+GL_METHOD(LinkAndReflect) {
+  GL_BOILERPLATE;
+
+  GLuint program = Nan::To<int32_t>(info[0]).ToChecked();
+
+  ProgramCache::Timer timer(ProgramCache::LINK);
+  double start = ShaderStats::Now();
+  glLinkProgram(program);
+  GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    inst->setError(error);
+    info.GetReturnValue().SetNull();
+    return;
+  }
+  inst->shaderStats.linkStarted(program, ShaderStats::Now() - start);
+
+  start = ShaderStats::Now();
+  info.GetReturnValue().Set(inst->reflectProgram(program));
+  inst->shaderStats.linkResolved(program, ShaderStats::Now() - start);
+}
+
+GL_METHOD(ReflectProgram) {
+  GL_BOILERPLATE;
+
+  GLuint program = Nan::To<int32_t>(info[0]).ToChecked();
+
+  // Reading back a program waits for its link to finish
+  double start = ShaderStats::Now();
+  info.GetReturnValue().Set(inst->reflectProgram(program));
+  inst->shaderStats.linkResolved(program, ShaderStats::Now() - start);
 }
 
 GL_METHOD(GetProgramParameter) {
   GL_BOILERPLATE;
 
-  GLint program = Nan::To<int32_t>(info[0]).ToChecked();
-  GLenum pname = (GLenum)(Nan::To<int32_t>(info[1]).ToChecked());
-  GLint value = 0;
+  GLint program = Nan::To<int32_t>(info[0]).ToChecked();
+  GLenum pname = (GLenum)(Nan::To<int32_t>(info[1]).ToChecked());
+  GLint value = 0;
+
+  glGetProgramiv(program, pname, &value);
+
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(value));
+}
+
+GL_METHOD(GetUniformLocation) {
+  GL_BOILERPLATE;
+
+  GLint program = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::Utf8String name(info[1]);
+
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(glGetUniformLocation(program, *name)));
+}
+
+GL_METHOD(ClearColor) {
+  GL_BOILERPLATE;
+
+  GLfloat red = static_cast<GLfloat>(Nan::To<double>(info[0]).ToChecked());
+  GLfloat green = static_cast<GLfloat>(Nan::To<double>(info[1]).ToChecked());
+  GLfloat blue = static_cast<GLfloat>(Nan::To<double>(info[2]).ToChecked());
+  GLfloat alpha = static_cast<GLfloat>(Nan::To<double>(info[3]).ToChecked());
+
+  glClearColor(red, green, blue, alpha);
+}
+
+GL_METHOD(ClearDepth) {
+  GL_BOILERPLATE;
+
+  GLfloat depth = static_cast<GLfloat>(Nan::To<double>(info[0]).ToChecked());
+
+  glClearDepthf(depth);
+}
+
+// Two specific enums are accepted by ANGLE when they shouldn't be. This shows up
+// for headless, but not browsers, because browsers do additional validation.
+// The ANGLE fix is to make EXT_multisample_compatibility "enableable".
+bool IsBuggedANGLECap(GLenum cap) { return cap == GL_MULTISAMPLE || cap == GL_SAMPLE_ALPHA_TO_ONE; }
+
+GL_METHOD(Disable) {
+  GL_BOILERPLATE;
+
+  GLenum cap = Nan::To<int32_t>(info[0]).ToChecked();
+
+  if (IsBuggedANGLECap(cap)) {
+    inst->setError(GL_INVALID_ENUM);
+  } else {
+    glDisable(cap);
+  }
+}
+
+GL_METHOD(Enable) {
+  GL_BOILERPLATE;
+
+  GLenum cap = Nan::To<int32_t>(info[0]).ToChecked();
+
+  if (IsBuggedANGLECap(cap)) {
+    inst->setError(GL_INVALID_ENUM);
+  } else {
+    glEnable(cap);
+  }
+}
+
+GL_METHOD(CreateTexture) {
+  GL_BOILERPLATE;
+
+  GLuint texture = 0;
+  glGenTextures(1, &texture);
+  inst->registerGLObj(GLOBJECT_TYPE_TEXTURE, texture);
+
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(texture));
+}
+
+GL_METHOD(BindTexture) {
+  GL_BOILERPLATE;
+
+  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint texture = Nan::To<int32_t>(info[1]).ToChecked();
+
+  glBindTexture(target, texture);
+  if (target == GL_TEXTURE_2D) {
+    inst->updateTextureUnit2D();
+  }
+}
+
+template <typename Kernel>
+void ForEachPixel(uint8_t *pixels, GLint width, GLint height, size_t rowStride,
+                  size_t bytesPerPixel, Kernel kernel) {
+  for (GLint row = 0; row < height; ++row) {
+    uint8_t *pixel = pixels + row * rowStride;
+    for (GLint col = 0; col < width; ++col, pixel += bytesPerPixel) {
+      kernel(pixel);
+    }
+  }
+}
+
+// Applies UNPACK_PREMULTIPLY_ALPHA_WEBGL. The kernel is picked once per image
+// so the per pixel loops don't branch on the format.
+void PremultiplyPixels(const PixelFormatDescriptor &descriptor, uint8_t *pixels, GLint width,
+                       GLint height, size_t rowStride) {
+  size_t bytesPerPixel = descriptor.bytesPerPixel;
+  switch (descriptor.premultiply) {
+  case PremultiplyKernel::None:
+    break;
+  case PremultiplyKernel::LuminanceAlpha8:
+    ForEachPixel(pixels, width, height, rowStride, bytesPerPixel,
+                 [](uint8_t *pixel) { pixel[0] *= pixel[1] / 255.0; });
+    break;
+  case PremultiplyKernel::RGBA8:
+    ForEachPixel(pixels, width, height, rowStride, bytesPerPixel, [](uint8_t *pixel) {
+      float scale = pixel[3] / 255.0;
+      pixel[0] *= scale;
+      pixel[1] *= scale;
+      pixel[2] *= scale;
+    });
+    break;
+  case PremultiplyKernel::RGBA4444:
+    ForEachPixel(pixels, width, height, rowStride, bytesPerPixel, [](uint8_t *pixel) {
+      int r = pixel[0] & 0x0f;
+      int g = pixel[0] >> 4;
+      int b = pixel[1] & 0x0f;
+      int a = pixel[1] >> 4;
+
+      float scale = a / 15.0;
+      r *= scale;
+      g *= scale;
+      b *= scale;
+
+      pixel[0] = r + (g << 4);
+      pixel[1] = b + (a << 4);
+    });
+    break;
+  case PremultiplyKernel::RGBA5551:
+    ForEachPixel(pixels, width, height, rowStride, bytesPerPixel, [](uint8_t *pixel) {
+      if ((pixel[0] & 1) == 0) {
+        pixel[0] = 1; // why does this get set to 1?!?!?!
+        pixel[1] = 0;
+      }
+    });
+    break;
+  case PremultiplyKernel::LuminanceAlphaFloat:
+    ForEachPixel(pixels, width, height, rowStride, bytesPerPixel, [](uint8_t *pixel) {
+      float la[2];
+      memcpy(la, pixel, sizeof(la));
+      la[0] *= la[1];
+      memcpy(pixel, la, sizeof(la));
+    });
+    break;
+  case PremultiplyKernel::RGBAFloat:
+    ForEachPixel(pixels, width, height, rowStride, bytesPerPixel, [](uint8_t *pixel) {
+      float rgba[4];
+      memcpy(rgba, pixel, sizeof(rgba));
+      rgba[0] *= rgba[3];
+      rgba[1] *= rgba[3];
+      rgba[2] *= rgba[3];
+      memcpy(pixel, rgba, sizeof(rgba));
+    });
+    break;
+  }
+}
+
+std::vector<uint8_t> WebGLRenderingContext::unpackPixels(GLenum type, GLenum format, GLint width,
+                                                         GLint height, const uint8_t *pixels,
+                                                         size_t byteLength) {
+  const PixelFormatDescriptor *descriptor = FindPixelFormat(format, type, webgl2);
+  if (!descriptor || width <= 0 || height <= 0) {
+    return std::vector<uint8_t>();
+  }
+
+  size_t rowSize = static_cast<size_t>(width) * descriptor->bytesPerPixel;
+  size_t rowStride = PixelRowStride(width, descriptor->bytesPerPixel, unpack_alignment);
+  size_t imageSize = PixelImageSize(width, height, descriptor->bytesPerPixel, unpack_alignment);
+
+  // Leave short buffers to GL, which reports the error
+  if (byteLength < imageSize) {
+    return std::vector<uint8_t>();
+  }
+
+  std::vector<uint8_t> unpacked(imageSize);
+  if (unpack_flip_y) {
+    for (GLint i = 0, j = height - 1; j >= 0; ++i, --j) {
+      memcpy(&unpacked[j * rowStride], pixels + i * rowStride, rowSize);
+    }
+  } else {
+    memcpy(unpacked.data(), pixels, imageSize);
+  }
+
+  if (unpack_premultiply_alpha) {
+    PremultiplyPixels(*descriptor, unpacked.data(), width, height, rowStride);
+  }
+
+  return unpacked;
+}
+
+void CallTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width,
+                    GLsizei height, GLint border, GLenum format, GLenum type, GLsizei bufSize,
+                    const void *pixels) {
+  GLenum sizedInternalFormat = SizeFloatingPointFormat(internalformat);
+  if (type == GL_FLOAT && sizedInternalFormat != internalformat) {
+    glTexStorage2DEXT(target, 1, sizedInternalFormat, width, height);
+    if (pixels) {
+      glTexSubImage2DRobustANGLE(target, level, 0, 0, width, height, format, type, bufSize, pixels);
+    }
+  } else {
+    glTexImage2DRobustANGLE(target, level, internalformat, width, height, border, format, type,
+                            bufSize, pixels);
+  }
+}
+
+// Unsized and sized format/type combinations that can be promoted from a
+// texImage2D mip chain to immutable texture storage.
+struct PromotableTextureFormat {
+  GLenum internalformat;
+  GLenum format;
+  GLenum type;
+  GLenum sizedInternalformat;
+  bool webgl2Only;
+};
+
+const PromotableTextureFormat PROMOTABLE_TEXTURE_FORMATS[] = {
+    {GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA8_OES, false},
+    {GL_RGB, GL_RGB, GL_UNSIGNED_BYTE, GL_RGB8_OES, false},
+    {GL_LUMINANCE_ALPHA, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, GL_LUMINANCE8_ALPHA8_EXT, false},
+    {GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_LUMINANCE8_EXT, false},
+    {GL_ALPHA, GL_ALPHA, GL_UNSIGNED_BYTE, GL_ALPHA8_EXT, false},
+    {GL_RGBA, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, GL_RGBA4, false},
+    {GL_RGBA, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, GL_RGB5_A1, false},
+    {GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, GL_RGB565, false},
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA8, true},
+    {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_SRGB8_ALPHA8, true},
+    {GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, GL_RGB8, true},
+    {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, GL_RG8, true},
+    {GL_R8, GL_RED, GL_UNSIGNED_BYTE, GL_R8, true},
+};
+
+const PromotableTextureFormat *FindPromotableTextureFormat(GLenum internalformat, GLenum format,
+                                                          GLenum type, bool webgl2) {
+  for (const PromotableTextureFormat &entry : PROMOTABLE_TEXTURE_FORMATS) {
+    if (entry.internalformat == internalformat && entry.format == format && entry.type == type) {
+      return (entry.webgl2Only && !webgl2) ? nullptr : &entry;
+    }
+  }
+  return nullptr;
+}
+
+GLsizei MipLevelCount(GLsizei width, GLsizei height) {
+  GLsizei size = std::max(width, height);
+  GLsizei levels = 1;
+  while (size >> levels) {
+    ++levels;
+  }
+  return levels;
+}
+
+GLsizei MipLevelSize(GLsizei size, GLint level) { return std::max(1, size >> level); }
+
+bool IsPowerOfTwo(GLsizei size) { return (size & (size - 1)) == 0; }
+
+size_t ImageBytes(GLsizei width, GLsizei height, GLsizei depth, size_t bytesPerPixel) {
+  if (width <= 0 || height <= 0 || depth <= 0) {
+    return 0;
+  }
+  return static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth) *
+         bytesPerPixel;
+}
+
+GLuint WebGLRenderingContext::boundTexture2D() {
+  GLint texture = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+  return static_cast<GLuint>(texture);
+}
+
+// Called after the TEXTURE_2D binding of the active texture unit changed
+void WebGLRenderingContext::updateTextureUnit2D() {
+  if (activeTextureUnit >= textureUnits2D.size()) {
+    return;
+  }
+  GLuint previous = textureUnits2D[activeTextureUnit];
+  GLuint texture = boundTexture2D();
+  textureUnits2D[activeTextureUnit] = texture;
+  if (pendingMipChains.count(texture)) {
+    sampledMipChains.insert(texture);
+  }
+  if (previous != texture && sampledMipChains.count(previous) &&
+      std::find(textureUnits2D.begin(), textureUnits2D.end(), previous) ==
+          textureUnits2D.end()) {
+    sampledMipChains.erase(previous);
+  }
+}
+
+// Promoted storage can only be redefined by copying its levels to a new
+// texture, which takes CHROMIUM_copy_texture. It isn't exposed to the
+// application, so it is enabled the first time it is needed. Without it, or
+// with another context that could see the texture, nothing is promoted.
+bool WebGLRenderingContext::canPromoteMipChains() {
+  if (!promoteTextureStorage || shareGroup.use_count() > 1) {
+    return false;
+  }
+  if (enabledExtensions.count("GL_CHROMIUM_copy_texture") == 0 &&
+      requestableExtensions->count("GL_CHROMIUM_copy_texture") > 0) {
+    glRequestExtensionANGLE("GL_CHROMIUM_copy_texture");
+    enabledExtensions.insert("GL_CHROMIUM_copy_texture");
+  }
+  return enabledExtensions.count("GL_CHROMIUM_copy_texture") > 0;
+}
+
+bool WebGLRenderingContext::hasDefaultUnpackLayout() {
+  if (!webgl2) {
+    return true;
+  }
+  const GLenum pnames[] = {GL_UNPACK_ROW_LENGTH, GL_UNPACK_SKIP_PIXELS, GL_UNPACK_SKIP_ROWS,
+                           GL_PIXEL_UNPACK_BUFFER_BINDING};
+  for (GLenum pname : pnames) {
+    GLint value = 0;
+    glGetIntegerv(pname, &value);
+    if (value != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Records a texImage2D call on TEXTURE_2D instead of issuing it when it starts
+// or continues a mip chain that can be promoted to immutable storage. Only
+// calls that are known to be valid are recorded, so holding them back never
+// hides a GL error. Returns false if the caller must issue the call itself.
+bool WebGLRenderingContext::deferTexImage2D(GLenum target, GLint level, GLenum internalformat,
+                                            GLsizei width, GLsizei height, GLint border,
+                                            GLenum format, GLenum type, const uint8_t *pixels,
+                                            size_t byteLength) {
+  if (!promoteTextureStorage || target != GL_TEXTURE_2D || border != 0) {
+    return false;
+  }
+
+  GLuint texture = boundTexture2D();
+  if (texture == 0) {
+    return false;
+  }
+
+  const PromotableTextureFormat *entry =
+      FindPromotableTextureFormat(internalformat, format, type, webgl2);
+
+  auto pending = pendingMipChains.find(texture);
+  if (pending != pendingMipChains.end()) {
+    PendingMipChain &chain = pending->second;
+    bool continuesChain = level == static_cast<GLint>(chain.levels.size()) &&
+                          internalformat == chain.internalformat && format == chain.format &&
+                          type == chain.type && width == MipLevelSize(chain.width, level) &&
+                          height == MipLevelSize(chain.height, level);
+    if (!continuesChain) {
+      if (level == 0 && chain.levels.size() == 1) {
+        // Level 0 is being replaced before anything else was specified.
+        pendingMipChains.erase(pending);
+      } else {
+        demoteMipChain(texture);
+        return false;
+      }
+    } else if (!hasDefaultUnpackLayout() ||
+               (pixels && byteLength < PixelImageSize(width, height, PixelFormatSize(format, type),
+                                                      unpack_alignment))) {
+      demoteMipChain(texture);
+      return false;
+    } else {
+      chain.levels.push_back({std::vector<uint8_t>(pixels, pixels + byteLength), unpack_alignment});
+      if (chain.levels.size() == static_cast<size_t>(chain.levelCount)) {
+        promoteMipChain(texture, false);
+      }
+      return true;
+    }
+  }
+
+  if (level != 0 || !entry || width <= 0 || height <= 0 || width > maxTextureSize ||
+      height > maxTextureSize || !canPromoteMipChains()) {
+    return false;
+  }
+
+  // WebGL 1 only allows mipmaps on power-of-two textures.
+  if (!webgl2 && !(IsPowerOfTwo(width) && IsPowerOfTwo(height))) {
+    return false;
+  }
+
+  GLsizei levelCount = MipLevelCount(width, height);
+  if (levelCount < 2 || !hasDefaultUnpackLayout()) {
+    return false;
+  }
+
+  if (pixels &&
+      byteLength < PixelImageSize(width, height, PixelFormatSize(format, type), unpack_alignment)) {
+    return false;
+  }
+
+  // Immutable textures can't be respecified, and textures that are not sampled
+  // with mipmaps are unlikely to ever get a full chain.
+  GLint immutable = 0;
+  glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_FORMAT_EXT, &immutable);
+  GLint minFilter = 0;
+  glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &minFilter);
+  if (immutable || minFilter == GL_NEAREST || minFilter == GL_LINEAR) {
+    return false;
+  }
+
+  PendingMipChain &chain = pendingMipChains[texture];
+  chain.internalformat = internalformat;
+  chain.sizedInternalformat = entry->sizedInternalformat;
+  chain.format = format;
+  chain.type = type;
+  chain.width = width;
+  chain.height = height;
+  chain.levelCount = levelCount;
+  chain.levels.push_back({std::vector<uint8_t>(pixels, pixels + byteLength), unpack_alignment});
+  sampledMipChains.insert(texture);
+  return true;
+}
+
+// Allocates the whole chain with one immutable storage call and uploads the
+// recorded levels into it.
+void WebGLRenderingContext::promoteMipChain(GLuint texture, bool generateMipmap) {
+  auto pending = pendingMipChains.find(texture);
+  if (pending == pendingMipChains.end()) {
+    return;
+  }
+  if (!canPromoteMipChains()) {
+    demoteMipChain(texture);
+    if (generateMipmap) {
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    return;
+  }
+  sampledMipChains.erase(texture);
+  PendingMipChain chain = std::move(pending->second);
+  pendingMipChains.erase(pending);
+
+  GLuint previous = boundTexture2D();
+  if (previous != texture) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+
+  glTexStorage2DEXT(GL_TEXTURE_2D, chain.levelCount, chain.sizedInternalformat, chain.width,
+                    chain.height);
+  for (size_t level = 0; level < chain.levels.size(); ++level) {
+    const PendingMipLevel &mip = chain.levels[level];
+    if (mip.pixels.empty()) {
+      continue;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, mip.alignment);
+    glTexSubImage2DRobustANGLE(GL_TEXTURE_2D, level, 0, 0, MipLevelSize(chain.width, level),
+                               MipLevelSize(chain.height, level), chain.format, chain.type,
+                               mip.pixels.size(), mip.pixels.data());
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+  if (generateMipmap) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  shareGroup->promotedMipChains[texture] = {chain.internalformat, chain.format, chain.type,
+                                            chain.width, chain.height, chain.levelCount};
+
+  if (previous != texture) {
+    glBindTexture(GL_TEXTURE_2D, previous);
+  }
+
+  promotedTextures += 1;
+  avoidedReallocations += chain.levelCount - 1;
+}
+
+// Replays the recorded levels as ordinary mutable texImage2D calls.
+void WebGLRenderingContext::demoteMipChain(GLuint texture) {
+  auto pending = pendingMipChains.find(texture);
+  if (pending == pendingMipChains.end()) {
+    return;
+  }
+  PendingMipChain chain = std::move(pending->second);
+  pendingMipChains.erase(pending);
+  sampledMipChains.erase(texture);
+
+  GLuint previous = boundTexture2D();
+  if (previous != texture) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+
+  for (size_t level = 0; level < chain.levels.size(); ++level) {
+    const PendingMipLevel &mip = chain.levels[level];
+    glPixelStorei(GL_UNPACK_ALIGNMENT, mip.alignment);
+    glTexImage2DRobustANGLE(GL_TEXTURE_2D, level, chain.internalformat,
+                            MipLevelSize(chain.width, level), MipLevelSize(chain.height, level), 0,
+                            chain.format, chain.type, mip.pixels.size(),
+                            mip.pixels.empty() ? nullptr : mip.pixels.data());
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+  if (previous != texture) {
+    glBindTexture(GL_TEXTURE_2D, previous);
+  }
+
+  demotedMipChains += 1;
+}
+
+void WebGLRenderingContext::demoteBoundMipChain(GLenum target) {
+  if (target == GL_TEXTURE_2D && !pendingMipChains.empty()) {
+    demoteMipChain(boundTexture2D());
+  }
+}
+
+void WebGLRenderingContext::demoteSampledMipChains() {
+  while (!sampledMipChains.empty()) {
+    GLuint texture = *sampledMipChains.begin();
+    sampledMipChains.erase(sampledMipChains.begin());
+    demoteMipChain(texture);
+  }
+}
+
+void WebGLRenderingContext::demoteAllMipChains() {
+  while (!pendingMipChains.empty()) {
+    demoteMipChain(pendingMipChains.begin()->first);
+  }
+}
+
+// A texImage2D that redefines a level of a promoted chain with the shape it
+// already has only replaces its contents, which immutable storage allows.
+// Returns false if the upload needs mutable storage instead.
+bool WebGLRenderingContext::updatePromotedTexture(GLenum target, GLint level,
+                                                  GLenum internalformat, GLsizei width,
+                                                  GLsizei height, GLint border, GLenum format,
+                                                  GLenum type, const uint8_t *pixels,
+                                                  size_t byteLength) {
+  if (target != GL_TEXTURE_2D || shareGroup->promotedMipChains.empty()) {
+    return false;
+  }
+  auto promoted = shareGroup->promotedMipChains.find(boundTexture2D());
+  if (promoted == shareGroup->promotedMipChains.end()) {
+    return false;
+  }
+  const PromotedMipChain &chain = promoted->second;
+  if (level < 0 || level >= chain.levelCount || border != 0 ||
+      internalformat != chain.internalformat || format != chain.format || type != chain.type ||
+      width != MipLevelSize(chain.width, level) || height != MipLevelSize(chain.height, level)) {
+    return false;
+  }
+
+  // A null upload leaves the level cleared, as new storage would be
+  std::vector<uint8_t> zeros;
+  if (!pixels) {
+    zeros.resize(PixelImageSize(width, height, PixelFormatSize(format, type), unpack_alignment));
+    pixels = zeros.data();
+    byteLength = zeros.size();
+  }
+  glTexSubImage2DRobustANGLE(GL_TEXTURE_2D, level, 0, 0, width, height, format, type, byteLength,
+                             pixels);
+  return true;
+}
+
+// Like updatePromotedTexture, for copyTexImage2D
+bool WebGLRenderingContext::copyToPromotedTexture(GLenum target, GLint level,
+                                                  GLenum internalformat, GLint x, GLint y,
+                                                  GLsizei width, GLsizei height, GLint border) {
+  if (target != GL_TEXTURE_2D || shareGroup->promotedMipChains.empty()) {
+    return false;
+  }
+  auto promoted = shareGroup->promotedMipChains.find(boundTexture2D());
+  if (promoted == shareGroup->promotedMipChains.end()) {
+    return false;
+  }
+  const PromotedMipChain &chain = promoted->second;
+  if (level < 0 || level >= chain.levelCount || border != 0 ||
+      internalformat != chain.internalformat || chain.type != GL_UNSIGNED_BYTE ||
+      width != MipLevelSize(chain.width, level) || height != MipLevelSize(chain.height, level)) {
+    return false;
+  }
+  glCopyTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, x, y, width, height);
+  return true;
+}
+
+// Immutable storage can't be redefined, so before any other call that
+// redefines a promoted texture, it is moved to a new, mutable texture that
+// takes over its levels, parameters, bindings and framebuffer attachments.
+// Returns the new name, which the wrapper has to adopt, or 0 if the texture
+// bound to target was not promoted.
+GLuint WebGLRenderingContext::unpromoteBoundTexture(GLenum target) {
+  if (target != GL_TEXTURE_2D || shareGroup->promotedMipChains.empty()) {
+    return 0;
+  }
+  return unpromoteTexture(boundTexture2D());
+}
+
+GLuint WebGLRenderingContext::unpromoteTexture(GLuint texture) {
+  auto promoted = shareGroup->promotedMipChains.find(texture);
+  if (promoted == shareGroup->promotedMipChains.end()) {
+    return 0;
+  }
+  PromotedMipChain chain = promoted->second;
+  shareGroup->promotedMipChains.erase(promoted);
+
+  GLuint previous = boundTexture2D();
+  if (previous != texture) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+  }
+
+  static const GLenum intParameters[] = {GL_TEXTURE_MIN_FILTER,   GL_TEXTURE_MAG_FILTER,
+                                         GL_TEXTURE_WRAP_S,       GL_TEXTURE_WRAP_T,
+                                         GL_TEXTURE_WRAP_R,       GL_TEXTURE_COMPARE_MODE,
+                                         GL_TEXTURE_COMPARE_FUNC, GL_TEXTURE_BASE_LEVEL,
+                                         GL_TEXTURE_MAX_LEVEL};
+  static const GLenum floatParameters[] = {GL_TEXTURE_MIN_LOD, GL_TEXTURE_MAX_LOD,
+                                          GL_TEXTURE_MAX_ANISOTROPY_EXT};
+  size_t intCount = webgl2 ? 9 : 4;
+  size_t floatCount = webgl2 ? 2 : 0;
+  bool anisotropic = enabledExtensions.count("GL_EXT_texture_filter_anisotropic") > 0;
+  GLint intValues[9];
+  GLfloat floatValues[3];
+  for (size_t i = 0; i < intCount; ++i) {
+    glGetTexParameteriv(GL_TEXTURE_2D, intParameters[i], &intValues[i]);
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    if (i < floatCount || (i == 2 && anisotropic)) {
+      glGetTexParameterfv(GL_TEXTURE_2D, floatParameters[i], &floatValues[i]);
+    }
+  }
+
+  GLuint replacement = 0;
+  glGenTextures(1, &replacement);
+  glBindTexture(GL_TEXTURE_2D, replacement);
+  for (size_t i = 0; i < intCount; ++i) {
+    glTexParameteri(GL_TEXTURE_2D, intParameters[i], intValues[i]);
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    if (i < floatCount || (i == 2 && anisotropic)) {
+      glTexParameterf(GL_TEXTURE_2D, floatParameters[i], floatValues[i]);
+    }
+  }
+
+  // Chains are only promoted with CHROMIUM_copy_texture enabled, and it
+  // copies every format they can have on the GPU
+  for (GLint level = 0; level < chain.levelCount; ++level) {
+    glCopyTextureCHROMIUM(texture, level, GL_TEXTURE_2D, replacement, level, chain.internalformat,
+                          chain.type, GL_FALSE, GL_FALSE, GL_FALSE);
+  }
+
+  // The memory accounting moves over as is
+  GLObjectSet &textures = shareGroup->objects[GLOBJECT_TYPE_TEXTURE];
+  GLObjectInfo *found = textures.find(texture);
+  GLObjectInfo moved = found ? std::move(*found) : GLObjectInfo();
+  textures.erase(texture);
+  textures.insert(replacement) = std::move(moved);
+
+  // No other context shares textures with this one, so its own bindings and
+  // attachments are the only ones that can refer to the texture
+  glBindTexture(GL_TEXTURE_2D, previous);
+  replaceTexture(texture, replacement);
+  glDeleteTextures(1, &texture);
+  return replacement;
+}
+
+// Gives up every promoted texture before another context starts sharing
+// textures with this one, and completes the recorded chains the slow way.
+// Returns the old and new names of the promoted textures in turn.
+GL_METHOD(UnpromoteTextures) {
+  GL_BOILERPLATE;
+
+  inst->demoteAllMipChains();
+
+  v8::Local<v8::Array> names = Nan::New<v8::Array>();
+  uint32_t count = 0;
+  while (!inst->shareGroup->promotedMipChains.empty()) {
+    GLuint texture = inst->shareGroup->promotedMipChains.begin()->first;
+    GLuint replacement = inst->unpromoteTexture(texture);
+    Nan::Set(names, count++, Nan::New<v8::Integer>(texture));
+    Nan::Set(names, count++, Nan::New<v8::Integer>(replacement));
+  }
+  info.GetReturnValue().Set(names);
+}
+
+// Rebinds the texture units and reattaches the framebuffer attachments of
+// this context that use texture to replacement
+void WebGLRenderingContext::replaceTexture(GLuint texture, GLuint replacement) {
+  GLint activeTexture = GL_TEXTURE0;
+  GLint maxTextureUnits = 0;
+  glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+  for (GLint i = 0; i < maxTextureUnits; ++i) {
+    glActiveTexture(GL_TEXTURE0 + i);
+    if (boundTexture2D() == texture) {
+      glBindTexture(GL_TEXTURE_2D, replacement);
+      if (static_cast<size_t>(i) < textureUnits2D.size()) {
+        textureUnits2D[i] = replacement;
+      }
+    }
+  }
+  glActiveTexture(activeTexture);
+
+  GLint maxColorAttachments = 1;
+  if (webgl2 || enabledExtensions.count("GL_EXT_draw_buffers") > 0) {
+    glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &maxColorAttachments);
+  }
+  GLenum framebufferTarget = webgl2 ? GL_DRAW_FRAMEBUFFER : GL_FRAMEBUFFER;
+  GLint previousFramebuffer = 0;
+  glGetIntegerv(webgl2 ? GL_DRAW_FRAMEBUFFER_BINDING : GL_FRAMEBUFFER_BINDING,
+                &previousFramebuffer);
+  const GLObjectSet &framebuffers = objects[GLOBJECT_TYPE_FRAMEBUFFER];
+  for (GLuint framebuffer : framebuffers.names()) {
+    glBindFramebuffer(framebufferTarget, framebuffer);
+    for (GLint i = 0; i < maxColorAttachments; ++i) {
+      GLenum attachment = GL_COLOR_ATTACHMENT0 + i;
+      GLint type = GL_NONE;
+      GLint name = 0;
+      glGetFramebufferAttachmentParameteriv(framebufferTarget, attachment,
+                                            GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
+      if (type != GL_TEXTURE) {
+        continue;
+      }
+      glGetFramebufferAttachmentParameteriv(framebufferTarget, attachment,
+                                            GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &name);
+      if (static_cast<GLuint>(name) == texture) {
+        GLint level = 0;
+        glGetFramebufferAttachmentParameteriv(framebufferTarget, attachment,
+                                              GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_LEVEL, &level);
+        glFramebufferTexture2D(framebufferTarget, attachment, GL_TEXTURE_2D, replacement, level);
+      }
+    }
+  }
+  glBindFramebuffer(framebufferTarget, previousFramebuffer);
+}
+
+GL_METHOD(TexImage2D) {
+  GL_BOILERPLATE;
+
+  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint level = Nan::To<int32_t>(info[1]).ToChecked();
+  GLenum internalformat = Nan::To<int32_t>(info[2]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[3]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[4]).ToChecked();
+  GLint border = Nan::To<int32_t>(info[5]).ToChecked();
+  GLenum format = Nan::To<int32_t>(info[6]).ToChecked();
+  GLint type = Nan::To<int32_t>(info[7]).ToChecked();
+  ArrayBufferContents pixels = GetArrayBufferContents(info[8]);
+
+  std::vector<uint8_t> unpacked;
+  const uint8_t *data = pixels.data;
+  size_t byteLength = pixels.byteLength;
+  if (data && (inst->unpack_flip_y || inst->unpack_premultiply_alpha)) {
+    unpacked = inst->unpackPixels(type, format, width, height, pixels.data, pixels.byteLength);
+    if (!unpacked.empty()) {
+      data = unpacked.data();
+      byteLength = unpacked.size();
+    }
+  }
+
+  if (inst->updatePromotedTexture(target, level, internalformat, width, height, border, format,
+                                  type, data, byteLength)) {
+    return;
+  }
+  GLuint replacement = inst->unpromoteBoundTexture(target);
+  if (replacement) {
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(replacement));
+  }
 
-  glGetProgramiv(program, pname, &value);
+  GLuint texture = inst->boundObject(target);
+  std::pair<GLenum, GLint> image(target, level);
+  size_t bytes = ImageBytes(width, height, 1, PixelFormatSize(format, type));
+  if (!inst->checkAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes)) {
+    return;
+  }
 
-  info.GetReturnValue().Set(Nan::New<v8::Integer>(value));
+  // Deferred levels were validated when they were queued
+  if (inst->deferTexImage2D(target, level, internalformat, width, height, border, format, type,
+                            data, byteLength)) {
+    inst->trackAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes);
+    return;
+  }
+
+  inst->flushGLErrors();
+  CallTexImage2D(target, level, internalformat, width, height, border, format, type, byteLength,
+                 data);
+  if (inst->glCallSucceeded()) {
+    inst->trackAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes);
+  }
 }
 
-GL_METHOD(GetUniformLocation) {
+GL_METHOD(GetTextureStorageStats) {
   GL_BOILERPLATE;
 
-  GLint program = Nan::To<int32_t>(info[0]).ToChecked();
-  Nan::Utf8String name(info[1]);
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New<v8::String>("promotedTextures").ToLocalChecked(),
+           Nan::New<v8::Number>(inst->promotedTextures));
+  Nan::Set(result, Nan::New<v8::String>("avoidedReallocations").ToLocalChecked(),
+           Nan::New<v8::Number>(inst->avoidedReallocations));
+  Nan::Set(result, Nan::New<v8::String>("demotedMipChains").ToLocalChecked(),
+           Nan::New<v8::Number>(inst->demotedMipChains));
+  Nan::Set(result, Nan::New<v8::String>("pendingMipChains").ToLocalChecked(),
+           Nan::New<v8::Number>(static_cast<double>(inst->pendingMipChains.size())));
 
-  info.GetReturnValue().Set(Nan::New<v8::Integer>(glGetUniformLocation(program, *name)));
+  info.GetReturnValue().Set(result);
 }
 
-GL_METHOD(ClearColor) {
-  GL_BOILERPLATE;
+// The drawing buffer's capacity grows in steps of this many pixels, so that
+// a run of slightly different sizes shares one allocation
+const GLsizei DRAWING_BUFFER_GRANULARITY = 64;
 
-  GLfloat red = static_cast<GLfloat>(Nan::To<double>(info[0]).ToChecked());
-  GLfloat green = static_cast<GLfloat>(Nan::To<double>(info[1]).ToChecked());
-  GLfloat blue = static_cast<GLfloat>(Nan::To<double>(info[2]).ToChecked());
-  GLfloat alpha = static_cast<GLfloat>(Nan::To<double>(info[3]).ToChecked());
+GLsizei DrawingBufferCapacity(GLsizei size, GLsizei maxSize) {
+  if (size >= maxSize) {
+    return size;
+  }
+  GLsizei rounded = (size + DRAWING_BUFFER_GRANULARITY - 1) / DRAWING_BUFFER_GRANULARITY *
+                    DRAWING_BUFFER_GRANULARITY;
+  return std::min(rounded, maxSize);
+}
+
+// Gives the drawing buffer a size of width by height. Sizes that fit in its
+// capacity only clear it, unless they would leave three quarters of it unused.
+// Otherwise the attachments are reallocated, with immutable storage for the
+// color texture, which therefore gets a new name. The bindings are left as they
+// were. Returns the name of the color texture.
+GLuint WebGLRenderingContext::resizeDrawingBuffer(GLsizei width, GLsizei height) {
+  DrawingBuffer &buffer = drawingBuffer;
+  bool fits = width <= buffer.capacityWidth && height <= buffer.capacityHeight;
+  bool wasteful = width <= buffer.capacityWidth / 2 && height <= buffer.capacityHeight / 2;
+  if (fits && !wasteful) {
+    buffer.width = width;
+    buffer.height = height;
+    clearDrawingBufferOutside(0, 0);
+    return buffer.color;
+  }
 
-  glClearColor(red, green, blue, alpha);
-}
+  // The first allocation and shrinking take the exact size. Growing keeps the
+  // capacity of the other dimension and leaves room to grow some more.
+  GLsizei capacityWidth = width;
+  GLsizei capacityHeight = height;
+  if (!fits && buffer.capacityWidth > 0) {
+    capacityWidth = DrawingBufferCapacity(std::max(width, buffer.capacityWidth), maxTextureSize);
+    capacityHeight =
+        DrawingBufferCapacity(std::max(height, buffer.capacityHeight), maxTextureSize);
+  }
 
-GL_METHOD(ClearDepth) {
-  GL_BOILERPLATE;
+  GLenum colorFormat = buffer.alpha ? GL_RGBA8_OES : GL_RGB8_OES;
+  GLenum depthStencilFormat = 0;
+  GLenum depthStencilAttachment = 0;
+  if (buffer.depth && buffer.stencil) {
+    depthStencilFormat = GL_DEPTH24_STENCIL8_OES;
+    depthStencilAttachment = GL_DEPTH_STENCIL_ATTACHMENT;
+  } else if (buffer.depth) {
+    depthStencilFormat = preferredDepth;
+    depthStencilAttachment = GL_DEPTH_ATTACHMENT;
+  } else if (buffer.stencil) {
+    depthStencilFormat = GL_STENCIL_INDEX8;
+    depthStencilAttachment = GL_STENCIL_ATTACHMENT;
+  }
+  size_t colorBytes =
+      ImageBytes(capacityWidth, capacityHeight, 1, InternalFormatSize(colorFormat));
+  size_t depthStencilBytes =
+      depthStencilFormat
+          ? ImageBytes(capacityWidth, capacityHeight, 1, InternalFormatSize(depthStencilFormat))
+          : 0;
+
+  // Check the limit against both attachments at once, so that a failure
+  // leaves the drawing buffer as it was
+  if (memoryLimit > 0) {
+    size_t previousBytes = 0;
+    for (auto object : {std::make_pair(GLOBJECT_TYPE_TEXTURE, buffer.color),
+                        std::make_pair(GLOBJECT_TYPE_RENDERBUFFER, buffer.depthStencil)}) {
+      GLObjectInfo *found = objectsOfType(object.first).find(object.second);
+      previousBytes += found ? found->bytes : 0;
+    }
+    if (static_cast<double>(shareGroup->bytes - previousBytes + colorBytes + depthStencilBytes) >
+        memoryLimit) {
+      setError(GL_OUT_OF_MEMORY);
+      return buffer.color;
+    }
+  }
 
-  GLfloat depth = static_cast<GLfloat>(Nan::To<double>(info[0]).ToChecked());
+  GLenum framebufferTarget = webgl2 ? GL_DRAW_FRAMEBUFFER : GL_FRAMEBUFFER;
+  GLint previousFramebuffer = 0;
+  GLint previousTexture = 0;
+  GLint previousRenderbuffer = 0;
+  glGetIntegerv(webgl2 ? GL_DRAW_FRAMEBUFFER_BINDING : GL_FRAMEBUFFER_BINDING,
+                &previousFramebuffer);
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+  glGetIntegerv(GL_RENDERBUFFER_BINDING, &previousRenderbuffer);
+
+  GLuint color = buffer.color;
+  if (buffer.capacityWidth > 0) {
+    unregisterGLObj(GLOBJECT_TYPE_TEXTURE, color);
+    glDeleteTextures(1, &color);
+    glGenTextures(1, &color);
+    registerGLObj(GLOBJECT_TYPE_TEXTURE, color);
+  }
+  trackStorage(GLOBJECT_TYPE_TEXTURE, color, colorBytes);
+  glBindTexture(GL_TEXTURE_2D, color);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexStorage2DEXT(GL_TEXTURE_2D, 1, colorFormat, capacityWidth, capacityHeight);
+
+  glBindFramebuffer(framebufferTarget, buffer.framebuffer);
+  glFramebufferTexture2D(framebufferTarget, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+  if (depthStencilFormat) {
+    trackStorage(GLOBJECT_TYPE_RENDERBUFFER, buffer.depthStencil, depthStencilBytes);
+    glBindRenderbuffer(GL_RENDERBUFFER, buffer.depthStencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, depthStencilFormat, capacityWidth, capacityHeight);
+    glFramebufferRenderbuffer(framebufferTarget, depthStencilAttachment, GL_RENDERBUFFER,
+                              buffer.depthStencil);
+  }
 
-  glClearDepthf(depth);
+  glBindFramebuffer(framebufferTarget, previousFramebuffer);
+  glBindTexture(GL_TEXTURE_2D, previousTexture);
+  glBindRenderbuffer(GL_RENDERBUFFER, previousRenderbuffer);
+
+  // New storage starts out cleared, as the context initializes resources
+  buffer.color = color;
+  buffer.width = width;
+  buffer.height = height;
+  buffer.capacityWidth = capacityWidth;
+  buffer.capacityHeight = capacityHeight;
+  return color;
 }
 
-// Two specific enums are accepted by ANGLE when they shouldn't be. This shows up
-// for headless, but not browsers, because browsers do additional validation.
-// The ANGLE fix is to make EXT_multisample_compatibility "enableable".
-bool IsBuggedANGLECap(GLenum cap) { return cap == GL_MULTISAMPLE || cap == GL_SAMPLE_ALPHA_TO_ONE; }
+// Clears the drawing buffer's storage outside of its first width by height
+// pixels, leaving the GL state as it was
+void WebGLRenderingContext::clearDrawingBufferOutside(GLsizei width, GLsizei height) {
+  DrawingBuffer &buffer = drawingBuffer;
+  if (width >= buffer.capacityWidth && height >= buffer.capacityHeight) {
+    return;
+  }
 
-GL_METHOD(Disable) {
-  GL_BOILERPLATE;
+  GLenum framebufferTarget = webgl2 ? GL_DRAW_FRAMEBUFFER : GL_FRAMEBUFFER;
+  GLint previousFramebuffer = 0;
+  GLfloat clearColor[4];
+  GLfloat clearDepth = 1;
+  GLint clearStencil = 0;
+  GLboolean colorMask[4];
+  GLboolean depthMask = GL_TRUE;
+  GLint stencilMask = 0;
+  GLint scissorBox[4];
+  glGetIntegerv(webgl2 ? GL_DRAW_FRAMEBUFFER_BINDING : GL_FRAMEBUFFER_BINDING,
+                &previousFramebuffer);
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+  glGetFloatv(GL_DEPTH_CLEAR_VALUE, &clearDepth);
+  glGetIntegerv(GL_STENCIL_CLEAR_VALUE, &clearStencil);
+  glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+  glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+  glGetIntegerv(GL_STENCIL_WRITEMASK, &stencilMask);
+  glGetIntegerv(GL_SCISSOR_BOX, scissorBox);
+  bool scissorTest = glIsEnabled(GL_SCISSOR_TEST);
+  bool rasterizerDiscard = webgl2 && glIsEnabled(GL_RASTERIZER_DISCARD);
+
+  glBindFramebuffer(framebufferTarget, buffer.framebuffer);
+  glClearColor(0, 0, 0, 0);
+  glClearDepthf(1);
+  glClearStencil(0);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glDepthMask(GL_TRUE);
+  glStencilMaskSeparate(GL_FRONT, 0xFFFFFFFF);
+  glEnable(GL_SCISSOR_TEST);
+  if (rasterizerDiscard) {
+    glDisable(GL_RASTERIZER_DISCARD);
+  }
 
-  GLenum cap = Nan::To<int32_t>(info[0]).ToChecked();
+  // The columns right of the kept area, then the rows above it
+  GLbitfield mask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+  width = std::max(width, 0);
+  height = std::max(height, 0);
+  if (width < buffer.capacityWidth) {
+    glScissor(width, 0, buffer.capacityWidth - width, buffer.capacityHeight);
+    glClear(mask);
+  }
+  if (height < buffer.capacityHeight && width > 0) {
+    glScissor(0, height, std::min(width, buffer.capacityWidth), buffer.capacityHeight - height);
+    glClear(mask);
+  }
 
-  if (IsBuggedANGLECap(cap)) {
-    inst->setError(GL_INVALID_ENUM);
-  } else {
-    glDisable(cap);
+  glBindFramebuffer(framebufferTarget, previousFramebuffer);
+  glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+  glClearDepthf(clearDepth);
+  glClearStencil(clearStencil);
+  glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+  glDepthMask(depthMask);
+  glStencilMaskSeparate(GL_FRONT, static_cast<GLuint>(stencilMask));
+  glScissor(scissorBox[0], scissorBox[1], scissorBox[2], scissorBox[3]);
+  if (!scissorTest) {
+    glDisable(GL_SCISSOR_TEST);
+  }
+  if (rasterizerDiscard) {
+    glEnable(GL_RASTERIZER_DISCARD);
   }
 }
 
-GL_METHOD(Enable) {
-  GL_BOILERPLATE;
-
-  GLenum cap = Nan::To<int32_t>(info[0]).ToChecked();
-
-  if (IsBuggedANGLECap(cap)) {
-    inst->setError(GL_INVALID_ENUM);
-  } else {
-    glEnable(cap);
+// Called before reading a rectangle of the read framebuffer. Pixels outside
+// the drawing buffer must read as zero, but when it is smaller than its
+// capacity, the storage past its edges holds whatever was drawn there, so
+// reads that reach past them clear it first.
+void WebGLRenderingContext::prepareDrawingBufferRead(GLint x, GLint y, GLsizei width,
+                                                     GLsizei height) {
+  DrawingBuffer &buffer = drawingBuffer;
+  if ((buffer.width == buffer.capacityWidth && buffer.height == buffer.capacityHeight) ||
+      width <= 0 || height <= 0 ||
+      (x >= 0 && y >= 0 && x + width <= buffer.width && y + height <= buffer.height)) {
+    return;
+  }
+  GLint framebuffer = 0;
+  glGetIntegerv(webgl2 ? GL_READ_FRAMEBUFFER_BINDING : GL_FRAMEBUFFER_BINDING, &framebuffer);
+  if (static_cast<GLuint>(framebuffer) == buffer.framebuffer) {
+    clearDrawingBufferOutside(buffer.width, buffer.height);
   }
 }
 
-GL_METHOD(CreateTexture) {
+GL_METHOD(ResizeDrawingBuffer) {
   GL_BOILERPLATE;
 
-  GLuint texture = 0;
-  glGenTextures(1, &texture);
-  inst->registerGLObj(GLOBJECT_TYPE_TEXTURE, texture);
-
-  info.GetReturnValue().Set(Nan::New<v8::Integer>(texture));
-}
+  DrawingBuffer &buffer = inst->drawingBuffer;
+  buffer.framebuffer = Nan::To<uint32_t>(info[0]).ToChecked();
+  buffer.color = Nan::To<uint32_t>(info[1]).ToChecked();
+  buffer.depthStencil = Nan::To<uint32_t>(info[2]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[3]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[4]).ToChecked();
 
-GL_METHOD(BindTexture) {
-  GL_BOILERPLATE;
+  GLuint color = inst->resizeDrawingBuffer(width, height);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(color));
+}
+
+GL_METHOD(GetMemoryInfo) {
+  GL_BOILERPLATE;
+
+  // The drawing buffer's framebuffer, color texture and depth/stencil
+  // renderbuffer, which are reported on their own
+  std::set<GLObjectReference> drawingBuffer = {
+      std::make_pair(Nan::To<uint32_t>(info[0]).FromMaybe(0), GLOBJECT_TYPE_FRAMEBUFFER),
+      std::make_pair(Nan::To<uint32_t>(info[1]).FromMaybe(0), GLOBJECT_TYPE_TEXTURE),
+      std::make_pair(Nan::To<uint32_t>(info[2]).FromMaybe(0), GLOBJECT_TYPE_RENDERBUFFER)};
+
+  static const struct {
+    GLObjectType type;
+    const char *name;
+  } types[] = {
+      {GLOBJECT_TYPE_BUFFER, "buffers"},
+      {GLOBJECT_TYPE_TEXTURE, "textures"},
+      {GLOBJECT_TYPE_RENDERBUFFER, "renderbuffers"},
+      {GLOBJECT_TYPE_FRAMEBUFFER, "framebuffers"},
+      {GLOBJECT_TYPE_PROGRAM, "programs"},
+      {GLOBJECT_TYPE_SHADER, "shaders"},
+      {GLOBJECT_TYPE_VERTEX_ARRAY, "vertexArrays"},
+  };
+  double counts[GLOBJECT_TYPE_COUNT] = {};
+  double bytes[GLOBJECT_TYPE_COUNT] = {};
+  double drawingBufferBytes = 0;
+  for (int t = 0; t < GLOBJECT_TYPE_COUNT; ++t) {
+    GLObjectType type = static_cast<GLObjectType>(t);
+    const GLObjectSet &list = inst->objectsOfType(type);
+    for (size_t i = 0; i < list.size(); ++i) {
+      double objectBytes = static_cast<double>(list.infoAt(i).bytes);
+      if (drawingBuffer.count(std::make_pair(list.names()[i], type))) {
+        drawingBufferBytes += objectBytes;
+      } else {
+        counts[type] += 1;
+        bytes[type] += objectBytes;
+      }
+    }
+  }
 
-  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
-  GLint texture = Nan::To<int32_t>(info[1]).ToChecked();
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  for (const auto &entry : types) {
+    v8::Local<v8::Object> totals = Nan::New<v8::Object>();
+    Nan::Set(totals, Nan::New<v8::String>("count").ToLocalChecked(),
+             Nan::New<v8::Number>(counts[entry.type]));
+    Nan::Set(totals, Nan::New<v8::String>("bytes").ToLocalChecked(),
+             Nan::New<v8::Number>(bytes[entry.type]));
+    Nan::Set(result, Nan::New<v8::String>(entry.name).ToLocalChecked(), totals);
+  }
+  Nan::Set(result, Nan::New<v8::String>("drawingBufferBytes").ToLocalChecked(),
+           Nan::New<v8::Number>(drawingBufferBytes));
+  Nan::Set(result, Nan::New<v8::String>("totalBytes").ToLocalChecked(),
+           Nan::New<v8::Number>(static_cast<double>(inst->shareGroup->bytes)));
+  Nan::Set(result, Nan::New<v8::String>("limit").ToLocalChecked(),
+           Nan::New<v8::Number>(inst->memoryLimit > 0 ? inst->memoryLimit : INFINITY));
 
-  glBindTexture(target, texture);
+  info.GetReturnValue().Set(result);
 }
 
-std::vector<uint8_t> WebGLRenderingContext::unpackPixels(GLenum type, GLenum format, GLint width,
-                                                         GLint height, unsigned char *pixels) {
+GL_METHOD(GetProgramCacheStats) {
+  GL_BOILERPLATE;
 
-  // Compute pixel size
-  GLint pixelSize = 1;
-  if (type == GL_UNSIGNED_BYTE || type == GL_FLOAT) {
-    if (type == GL_FLOAT) {
-      pixelSize = 4;
-    }
-    switch (format) {
-    case GL_ALPHA:
-    case GL_LUMINANCE:
-      break;
-    case GL_LUMINANCE_ALPHA:
-      pixelSize *= 2;
-      break;
-    case GL_RGB:
-      pixelSize *= 3;
-      break;
-    case GL_RGBA:
-      pixelSize *= 4;
-      break;
-    }
-  } else {
-    pixelSize = 2;
-  }
+  ProgramCache::Stats stats = ProgramCache::GetStats();
 
-  // Compute row stride
-  GLint rowStride = pixelSize * width;
-  if ((rowStride % unpack_alignment) != 0) {
-    rowStride += unpack_alignment - (rowStride % unpack_alignment);
-  }
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New<v8::String>("enabled").ToLocalChecked(),
+           Nan::New<v8::Boolean>(ProgramCache::IsInstalled()));
+  Nan::Set(result, Nan::New<v8::String>("dir").ToLocalChecked(),
+           Nan::New<v8::String>(ProgramCache::Directory()).ToLocalChecked());
+  Nan::Set(result, Nan::New<v8::String>("hits").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.hits));
+  Nan::Set(result, Nan::New<v8::String>("misses").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.misses));
+  Nan::Set(result, Nan::New<v8::String>("writes").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.writes));
+  Nan::Set(result, Nan::New<v8::String>("evictions").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.evictions));
+  Nan::Set(result, Nan::New<v8::String>("bytes").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.bytes));
+  Nan::Set(result, Nan::New<v8::String>("memoryBytes").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.memoryBytes));
+  Nan::Set(result, Nan::New<v8::String>("savedMs").ToLocalChecked(),
+           Nan::New<v8::Number>(stats.savedMs));
 
-  GLint imageSize = rowStride * height;
-  std::vector<uint8_t> unpacked(imageSize);
+  info.GetReturnValue().Set(result);
+}
 
-  if (unpack_flip_y) {
-    for (int i = 0, j = height - 1; j >= 0; ++i, --j) {
-      memcpy(&unpacked[j * rowStride], reinterpret_cast<void *>(pixels + i * rowStride),
-             width * pixelSize);
-    }
-  } else {
-    memcpy(unpacked.data(), reinterpret_cast<void *>(pixels), imageSize);
-  }
-
-  // Premultiply alpha unpacking
-  if (unpack_premultiply_alpha && (format == GL_LUMINANCE_ALPHA || format == GL_RGBA)) {
-
-    for (int row = 0; row < height; ++row) {
-      for (int col = 0; col < width; ++col) {
-        uint8_t *pixel = &unpacked[(row * rowStride) + (col * pixelSize)];
-        if (format == GL_LUMINANCE_ALPHA) {
-          pixel[0] *= pixel[1] / 255.0;
-        } else if (type == GL_UNSIGNED_BYTE) {
-          float scale = pixel[3] / 255.0;
-          pixel[0] *= scale;
-          pixel[1] *= scale;
-          pixel[2] *= scale;
-        } else if (type == GL_UNSIGNED_SHORT_4_4_4_4) {
-          int r = pixel[0] & 0x0f;
-          int g = pixel[0] >> 4;
-          int b = pixel[1] & 0x0f;
-          int a = pixel[1] >> 4;
-
-          float scale = a / 15.0;
-          r *= scale;
-          g *= scale;
-          b *= scale;
-
-          pixel[0] = r + (g << 4);
-          pixel[1] = b + (a << 4);
-        } else if (type == GL_UNSIGNED_SHORT_5_5_5_1) {
-          if ((pixel[0] & 1) == 0) {
-            pixel[0] = 1; // why does this get set to 1?!?!?!
-            pixel[1] = 0;
-          }
-        }
-      }
+v8::Local<v8::Array> ShaderStatsEntries(const std::map<uint64_t, ShaderStats::Entry> &entries) {
+  v8::Local<v8::Array> result = Nan::New<v8::Array>();
+  uint32_t index = 0;
+  for (const auto &item : entries) {
+    const ShaderStats::Entry &entry = item.second;
+    if (entry.count == 0) {
+      continue;
     }
-  }
 
-  return unpacked;
-}
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(item.first));
+    v8::Local<v8::Array> ids = Nan::New<v8::Array>(static_cast<int>(entry.ids.size()));
+    uint32_t idIndex = 0;
+    for (GLuint id : entry.ids) {
+      Nan::Set(ids, idIndex++, Nan::New<v8::Integer>(id));
+    }
 
-void CallTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width,
-                    GLsizei height, GLint border, GLenum format, GLenum type, GLsizei bufSize,
-                    const void *pixels) {
-  GLenum sizedInternalFormat = SizeFloatingPointFormat(internalformat);
-  if (type == GL_FLOAT && sizedInternalFormat != internalformat) {
-    glTexStorage2DEXT(target, 1, sizedInternalFormat, width, height);
-    if (pixels) {
-      glTexSubImage2DRobustANGLE(target, level, 0, 0, width, height, format, type, bufSize, pixels);
+    v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+    Nan::Set(stats, Nan::New<v8::String>("hash").ToLocalChecked(),
+             Nan::New<v8::String>(hash).ToLocalChecked());
+    if (entry.type) {
+      Nan::Set(stats, Nan::New<v8::String>("type").ToLocalChecked(),
+               Nan::New<v8::Integer>(entry.type));
     }
-  } else {
-    glTexImage2DRobustANGLE(target, level, internalformat, width, height, border, format, type,
-                            bufSize, pixels);
+    Nan::Set(stats, Nan::New<v8::String>("sourceBytes").ToLocalChecked(),
+             Nan::New<v8::Number>(entry.sourceBytes));
+    Nan::Set(stats, Nan::New<v8::String>("count").ToLocalChecked(),
+             Nan::New<v8::Number>(entry.count));
+    Nan::Set(stats, Nan::New<v8::String>("totalMs").ToLocalChecked(),
+             Nan::New<v8::Number>(entry.totalMs));
+    Nan::Set(stats, Nan::New<v8::String>("maxMs").ToLocalChecked(),
+             Nan::New<v8::Number>(entry.maxMs));
+    Nan::Set(stats, Nan::New<v8::String>("ids").ToLocalChecked(), ids);
+    Nan::Set(result, index++, stats);
   }
+  return result;
 }
 
-GL_METHOD(TexImage2D) {
+GL_METHOD(GetShaderStats) {
   GL_BOILERPLATE;
 
-  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
-  GLint level = Nan::To<int32_t>(info[1]).ToChecked();
-  GLenum internalformat = Nan::To<int32_t>(info[2]).ToChecked();
-  GLsizei width = Nan::To<int32_t>(info[3]).ToChecked();
-  GLsizei height = Nan::To<int32_t>(info[4]).ToChecked();
-  GLint border = Nan::To<int32_t>(info[5]).ToChecked();
-  GLenum format = Nan::To<int32_t>(info[6]).ToChecked();
-  GLint type = Nan::To<int32_t>(info[7]).ToChecked();
-  Nan::TypedArrayContents<unsigned char> pixels(info[8]);
-
-  if (*pixels) {
-    if (inst->unpack_flip_y || inst->unpack_premultiply_alpha) {
-      std::vector<uint8_t> unpacked = inst->unpackPixels(type, format, width, height, *pixels);
-      CallTexImage2D(target, level, internalformat, width, height, border, format, type,
-                     unpacked.size(), unpacked.data());
-    } else {
-      CallTexImage2D(target, level, internalformat, width, height, border, format, type,
-                     pixels.length(), *pixels);
-    }
-  } else {
-    CallTexImage2D(target, level, internalformat, width, height, border, format, type, 0, nullptr);
+  v8::Local<v8::Object> histograms = Nan::New<v8::Object>();
+  for (const auto &item : ShaderStats::GetHistograms()) {
+    v8::Local<v8::Object> histogram = Nan::New<v8::Object>();
+    Nan::Set(histogram, Nan::New<v8::String>("count").ToLocalChecked(),
+             Nan::New<v8::Number>(item.second.count));
+    Nan::Set(histogram, Nan::New<v8::String>("sum").ToLocalChecked(),
+             Nan::New<v8::Number>(item.second.sum));
+    Nan::Set(histogram, Nan::New<v8::String>("min").ToLocalChecked(),
+             Nan::New<v8::Number>(item.second.min));
+    Nan::Set(histogram, Nan::New<v8::String>("max").ToLocalChecked(),
+             Nan::New<v8::Number>(item.second.max));
+    Nan::Set(histograms, Nan::New<v8::String>(item.first).ToLocalChecked(), histogram);
   }
+
+  v8::Local<v8::Object> result = Nan::New<v8::Object>();
+  Nan::Set(result, Nan::New<v8::String>("shaders").ToLocalChecked(),
+           ShaderStatsEntries(inst->shaderStats.shaders));
+  Nan::Set(result, Nan::New<v8::String>("programs").ToLocalChecked(),
+           ShaderStatsEntries(inst->shaderStats.programs));
+  Nan::Set(result, Nan::New<v8::String>("histograms").ToLocalChecked(), histograms);
+
+  info.GetReturnValue().Set(result);
 }
 
 GL_METHOD(TexSubImage2D) {
@@ -1053,15 +2823,21 @@ GL_METHOD(TexSubImage2D) {
   GLsizei height = Nan::To<int32_t>(info[5]).ToChecked();
   GLenum format = Nan::To<int32_t>(info[6]).ToChecked();
   GLenum type = Nan::To<int32_t>(info[7]).ToChecked();
-  Nan::TypedArrayContents<unsigned char> pixels(info[8]);
+  ArrayBufferContents pixels = GetArrayBufferContents(info[8]);
 
-  if (inst->unpack_flip_y || inst->unpack_premultiply_alpha) {
-    std::vector<uint8_t> unpacked = inst->unpackPixels(type, format, width, height, *pixels);
+  inst->demoteBoundMipChain(target);
+
+  std::vector<uint8_t> unpacked;
+  if (pixels.data && (inst->unpack_flip_y || inst->unpack_premultiply_alpha)) {
+    unpacked = inst->unpackPixels(type, format, width, height, pixels.data, pixels.byteLength);
+  }
+
+  if (!unpacked.empty()) {
     glTexSubImage2DRobustANGLE(target, level, xoffset, yoffset, width, height, format, type,
                                unpacked.size(), unpacked.data());
   } else {
     glTexSubImage2DRobustANGLE(target, level, xoffset, yoffset, width, height, format, type,
-                               pixels.length(), *pixels);
+                               pixels.byteLength, pixels.data);
   }
 }
 
@@ -1144,6 +2920,8 @@ GL_METHOD(FramebufferTexture2D) {
   GLint texture = Nan::To<int32_t>(info[3]).ToChecked();
   GLint level = Nan::To<int32_t>(info[4]).ToChecked();
 
+  inst->demoteMipChain(texture);
+
   // Handle depth stencil case separately
   if (attachment == 0x821A) {
     glFramebufferTexture2D(target, GL_DEPTH_ATTACHMENT, textarget, texture, level);
@@ -1159,11 +2937,26 @@ GL_METHOD(BufferData) {
   GLint target = Nan::To<int32_t>(info[0]).ToChecked();
   GLenum usage = Nan::To<int32_t>(info[2]).ToChecked();
 
+  GLuint buffer = inst->boundObject(target);
   if (info[1]->IsObject()) {
-    Nan::TypedArrayContents<char> array(info[1]);
-    glBufferData(target, array.length(), static_cast<void *>(*array), usage);
+    ArrayBufferContents array = GetArrayBufferContents(info[1]);
+    if (inst->checkStorage(GLOBJECT_TYPE_BUFFER, buffer, array.byteLength)) {
+      inst->flushGLErrors();
+      glBufferData(target, array.byteLength, array.data, usage);
+      if (inst->glCallSucceeded()) {
+        inst->trackStorage(GLOBJECT_TYPE_BUFFER, buffer, array.byteLength);
+      }
+    }
   } else if (info[1]->IsNumber()) {
-    glBufferData(target, Nan::To<int32_t>(info[1]).ToChecked(), NULL, usage);
+    GLsizeiptr size = Nan::To<int32_t>(info[1]).ToChecked();
+    size_t bytes = static_cast<size_t>(std::max<GLsizeiptr>(size, 0));
+    if (inst->checkStorage(GLOBJECT_TYPE_BUFFER, buffer, bytes)) {
+      inst->flushGLErrors();
+      glBufferData(target, size, NULL, usage);
+      if (inst->glCallSucceeded()) {
+        inst->trackStorage(GLOBJECT_TYPE_BUFFER, buffer, bytes);
+      }
+    }
   }
 }
 
@@ -1172,9 +2965,9 @@ GL_METHOD(BufferSubData) {
 
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint offset = Nan::To<int32_t>(info[1]).ToChecked();
-  Nan::TypedArrayContents<char> array(info[2]);
+  ArrayBufferContents array = GetArrayBufferContents(info[2]);
 
-  glBufferSubData(target, offset, array.length(), *array);
+  glBufferSubData(target, offset, array.byteLength, array.data);
 }
 
 GL_METHOD(BlendEquation) {
@@ -1217,6 +3010,9 @@ GL_METHOD(ActiveTexture) {
   GL_BOILERPLATE;
 
   glActiveTexture(Nan::To<int32_t>(info[0]).ToChecked());
+  GLint activeTexture = GL_TEXTURE0;
+  glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+  inst->activeTextureUnit = activeTexture - GL_TEXTURE0;
 }
 
 GL_METHOD(DrawElements) {
@@ -1227,6 +3023,7 @@ GL_METHOD(DrawElements) {
   GLenum type = Nan::To<int32_t>(info[2]).ToChecked();
   size_t offset = Nan::To<uint32_t>(info[3]).ToChecked();
 
+  inst->demoteSampledMipChains();
   glDrawElements(mode, count, type, reinterpret_cast<GLvoid *>(offset));
 }
 
@@ -1346,7 +3143,29 @@ GL_METHOD(CopyTexImage2D) {
   GLsizei height = Nan::To<int32_t>(info[6]).ToChecked();
   GLint border = Nan::To<int32_t>(info[7]).ToChecked();
 
+  if (inst->copyToPromotedTexture(target, level, internalformat, x, y, width, height, border)) {
+    return;
+  }
+  GLuint replacement = inst->unpromoteBoundTexture(target);
+  if (replacement) {
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(replacement));
+  }
+
+  GLuint texture = inst->boundObject(target);
+  std::pair<GLenum, GLint> image(target, level);
+  size_t bytes = ImageBytes(width, height, 1, InternalFormatSize(internalformat));
+  if (!inst->checkAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes)) {
+    return;
+  }
+
+  inst->demoteBoundMipChain(target);
+  inst->prepareDrawingBufferRead(x, y, width, height);
+
+  inst->flushGLErrors();
   glCopyTexImage2D(target, level, internalformat, x, y, width, height, border);
+  if (inst->glCallSucceeded()) {
+    inst->trackAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes);
+  }
 }
 
 GL_METHOD(CopyTexSubImage2D) {
@@ -1361,6 +3180,9 @@ GL_METHOD(CopyTexSubImage2D) {
   GLsizei width = Nan::To<int32_t>(info[6]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[7]).ToChecked();
 
+  inst->demoteBoundMipChain(target);
+  inst->prepareDrawingBufferRead(x, y, width, height);
+
   glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
 }
 
@@ -1557,6 +3379,7 @@ GL_METHOD(DeleteProgram) {
   GLuint program = Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_PROGRAM, program);
+  inst->shaderStats.deleteProgram(program);
 
   glDeleteProgram(program);
 }
@@ -1577,6 +3400,7 @@ GL_METHOD(DeleteShader) {
   GLuint shader = Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_SHADER, shader);
+  inst->shaderStats.deleteShader(shader);
 
   glDeleteShader(shader);
 }
@@ -1587,6 +3411,7 @@ GL_METHOD(DeleteTexture) {
   GLuint texture = Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_TEXTURE, texture);
+  inst->pendingMipChains.erase(texture);
 
   glDeleteTextures(1, &texture);
 }
@@ -1681,7 +3506,17 @@ GL_METHOD(RenderbufferStorage) {
     internalformat = inst->preferredDepth;
   }
 
+  GLuint renderbuffer = inst->boundObject(target);
+  size_t bytes = ImageBytes(width, height, 1, InternalFormatSize(internalformat));
+  if (!inst->checkStorage(GLOBJECT_TYPE_RENDERBUFFER, renderbuffer, bytes)) {
+    return;
+  }
+
+  inst->flushGLErrors();
   glRenderbufferStorage(target, internalformat, width, height);
+  if (inst->glCallSucceeded()) {
+    inst->trackStorage(GLOBJECT_TYPE_RENDERBUFFER, renderbuffer, bytes);
+  }
 }
 
 GL_METHOD(GetShaderSource) {
@@ -1709,9 +3544,39 @@ GL_METHOD(ReadPixels) {
   GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
   GLenum format = Nan::To<int32_t>(info[4]).ToChecked();
   GLenum type = Nan::To<int32_t>(info[5]).ToChecked();
-  Nan::TypedArrayContents<char> pixels(info[6]);
 
-  glReadPixels(x, y, width, height, format, type, *pixels);
+  inst->prepareDrawingBufferRead(x, y, width, height);
+
+  if (inst->webgl2) {
+    GLint packBuffer = 0;
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+    if (packBuffer != 0) {
+      GLintptr offset = info[6]->IsNumber() ? Nan::To<int64_t>(info[6]).ToChecked() : 0;
+      glReadPixels(x, y, width, height, format, type, reinterpret_cast<void *>(offset));
+      return;
+    }
+  }
+
+  ArrayBufferContents pixels = GetArrayBufferContents(info[6]);
+
+  // Check the destination against the size the format/type pair needs, rather
+  // than letting GL write past the end of a short buffer
+  const PixelFormatDescriptor *descriptor = FindPixelFormat(format, type, inst->webgl2);
+  if (descriptor && width > 0 && height > 0) {
+    GLint packAlignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    size_t imageSize = PixelImageSize(width, height, descriptor->bytesPerPixel, packAlignment);
+    if (!pixels.data || pixels.byteLength < imageSize) {
+      inst->setError(GL_INVALID_OPERATION);
+      return;
+    }
+  }
+
+  GLsizei length = 0;
+  GLsizei columns = 0;
+  GLsizei rows = 0;
+  glReadPixelsRobustANGLE(x, y, width, height, format, type, pixels.byteLength, &length, &columns,
+                          &rows, pixels.data);
 }
 
 GL_METHOD(GetTexParameter) {
@@ -2113,7 +3978,7 @@ GL_METHOD(GetVertexAttrib) {
 GL_METHOD(GetSupportedExtensions) {
   GL_BOILERPLATE;
 
-  std::string extensions = JoinStringSet(inst->supportedWebGLExtensions);
+  std::string extensions = JoinStringSet(*inst->supportedWebGLExtensions);
 
   v8::Local<v8::String> exts = Nan::New<v8::String>(extensions).ToLocalChecked();
 
@@ -2125,12 +3990,12 @@ GL_METHOD(GetExtension) {
 
   Nan::Utf8String name(info[0]);
 
-  auto extsIter = inst->webGLToANGLEExtensions.find(*name);
-  if (extsIter == inst->webGLToANGLEExtensions.end()) {
+  auto extsIter = inst->webGLToANGLEExtensions->find(*name);
+  if (extsIter == inst->webGLToANGLEExtensions->end()) {
     printf("Warning: no record of ANGLE exts for WebGL extension: %s\n", *name);
   } else {
     for (const std::string &ext : extsIter->second) {
-      if (inst->requestableExtensions.count(ext.c_str()) == 0) {
+      if (inst->requestableExtensions->count(ext.c_str()) == 0) {
         printf("Warning: could not enable ANGLE extension: %s\n", ext.c_str());
       } else if (inst->enabledExtensions.count(ext.c_str()) == 0) {
         glRequestExtensionANGLE(ext.c_str());
@@ -2311,6 +4176,8 @@ GL_METHOD(BlitFramebuffer) {
   GLint dstY1 = Nan::To<int32_t>(info[7]).ToChecked();
   GLbitfield mask = Nan::To<uint32_t>(info[8]).ToChecked();
   GLenum filter = Nan::To<int32_t>(info[9]).ToChecked();
+  inst->prepareDrawingBufferRead(std::min(srcX0, srcX1), std::min(srcY0, srcY1),
+                                 std::abs(srcX1 - srcX0), std::abs(srcY1 - srcY0));
   glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
 }
 
@@ -2375,7 +4242,17 @@ GL_METHOD(RenderbufferStorageMultisample) {
   GLenum internalformat = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei width = Nan::To<int32_t>(info[3]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[4]).ToChecked();
+  GLuint renderbuffer = inst->boundObject(target);
+  size_t bytes =
+      ImageBytes(width, height, std::max(samples, 1), InternalFormatSize(internalformat));
+  if (!inst->checkStorage(GLOBJECT_TYPE_RENDERBUFFER, renderbuffer, bytes)) {
+    return;
+  }
+  inst->flushGLErrors();
   glRenderbufferStorageMultisample(target, samples, internalformat, width, height);
+  if (inst->glCallSucceeded()) {
+    inst->trackStorage(GLOBJECT_TYPE_RENDERBUFFER, renderbuffer, bytes);
+  }
 }
 
 GL_METHOD(TexStorage2D) {
@@ -2385,7 +4262,27 @@ GL_METHOD(TexStorage2D) {
   GLenum internalformat = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei width = Nan::To<int32_t>(info[3]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[4]).ToChecked();
+  size_t bytes = 0;
+  for (GLint level = 0; level < levels; ++level) {
+    bytes += ImageBytes(MipLevelSize(width, level), MipLevelSize(height, level),
+                        target == GL_TEXTURE_CUBE_MAP ? 6 : 1, InternalFormatSize(internalformat));
+  }
+  GLuint replacement = inst->unpromoteBoundTexture(target);
+  if (replacement) {
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(replacement));
+  }
+  GLuint texture = inst->boundObject(target);
+  if (!inst->checkStorage(GLOBJECT_TYPE_TEXTURE, texture, bytes)) {
+    return;
+  }
+  if (target == GL_TEXTURE_2D && !inst->pendingMipChains.empty()) {
+    inst->pendingMipChains.erase(inst->boundTexture2D());
+  }
+  inst->flushGLErrors();
   glTexStorage2D(target, levels, internalformat, width, height);
+  if (inst->glCallSucceeded()) {
+    inst->trackStorage(GLOBJECT_TYPE_TEXTURE, texture, bytes);
+  }
 }
 
 GL_METHOD(TexStorage3D) {
@@ -2396,7 +4293,22 @@ GL_METHOD(TexStorage3D) {
   GLsizei width = Nan::To<int32_t>(info[3]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[4]).ToChecked();
   GLsizei depth = Nan::To<int32_t>(info[5]).ToChecked();
+  size_t bytes = 0;
+  for (GLint level = 0; level < levels; ++level) {
+    // Only 3D textures shrink in depth
+    bytes += ImageBytes(MipLevelSize(width, level), MipLevelSize(height, level),
+                        target == GL_TEXTURE_3D ? MipLevelSize(depth, level) : depth,
+                        InternalFormatSize(internalformat));
+  }
+  GLuint texture = inst->boundObject(target);
+  if (!inst->checkStorage(GLOBJECT_TYPE_TEXTURE, texture, bytes)) {
+    return;
+  }
+  inst->flushGLErrors();
   glTexStorage3D(target, levels, internalformat, width, height, depth);
+  if (inst->glCallSucceeded()) {
+    inst->trackStorage(GLOBJECT_TYPE_TEXTURE, texture, bytes);
+  }
 }
 
 GL_METHOD(TexImage3D) {
@@ -2410,16 +4322,27 @@ GL_METHOD(TexImage3D) {
   GLint border = Nan::To<int32_t>(info[6]).ToChecked();
   GLenum format = Nan::To<int32_t>(info[7]).ToChecked();
   GLenum type = Nan::To<int32_t>(info[8]).ToChecked();
-  if (info[9]->IsUndefined()) {
+  GLuint texture = inst->boundObject(target);
+  std::pair<GLenum, GLint> image(target, level);
+  size_t bytes = ImageBytes(width, height, depth, PixelFormatSize(format, type));
+  if (!inst->checkAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes)) {
+    return;
+  }
+  inst->flushGLErrors();
+  if (info[9]->IsNullOrUndefined()) {
     glTexImage3D(target, level, internalformat, width, height, depth, border, format, type,
                  nullptr);
-  } else if (info[9]->IsArrayBufferView()) {
-    auto buffer = info[9].As<v8::ArrayBufferView>();
-    void *bufferPtr = buffer->Buffer()->GetBackingStore()->Data();
-    glTexImage3D(target, level, internalformat, width, height, depth, border, format, type,
-                 bufferPtr);
+  } else if (info[9]->IsArrayBufferView() || info[9]->IsArrayBuffer() ||
+             info[9]->IsSharedArrayBuffer()) {
+    ArrayBufferContents pixels = GetArrayBufferContents(info[9]);
+    glTexImage3DRobustANGLE(target, level, internalformat, width, height, depth, border, format,
+                            type, pixels.byteLength, pixels.data);
   } else {
     Nan::ThrowTypeError("Invalid data type for TexImage3D");
+    return;
+  }
+  if (inst->glCallSucceeded()) {
+    inst->trackAllocation(GLOBJECT_TYPE_TEXTURE, texture, image, bytes);
   }
 }
 
@@ -2435,19 +4358,159 @@ GL_METHOD(TexSubImage3D) {
   GLsizei depth = Nan::To<int32_t>(info[7]).ToChecked();
   GLenum format = Nan::To<int32_t>(info[8]).ToChecked();
   GLenum type = Nan::To<int32_t>(info[9]).ToChecked();
-  if (info[10]->IsUndefined()) {
+  if (info[10]->IsNullOrUndefined()) {
     glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type,
                     nullptr);
-  } else if (info[10]->IsArrayBufferView()) {
-    auto buffer = info[10].As<v8::ArrayBufferView>();
-    void *bufferPtr = buffer->Buffer()->GetBackingStore()->Data();
-    glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type,
-                    bufferPtr);
+  } else if (info[10]->IsArrayBufferView() || info[10]->IsArrayBuffer() ||
+             info[10]->IsSharedArrayBuffer()) {
+    ArrayBufferContents pixels = GetArrayBufferContents(info[10]);
+    glTexSubImage3DRobustANGLE(target, level, xoffset, yoffset, zoffset, width, height, depth,
+                               format, type, pixels.byteLength, pixels.data);
   } else {
     Nan::ThrowTypeError("Invalid data type for TexSubImage3D");
   }
 }
 
+// Reads the layer images passed to texSubImage3DLayers, either an array of
+// buffers or views with one layer each, or {buffer, offsets} with the byte
+// offset of each layer in a single buffer. Returns false on a malformed list.
+bool GetLayerContents(v8::Local<v8::Value> value, std::vector<ArrayBufferContents> &layers) {
+  if (value->IsArray()) {
+    v8::Local<v8::Array> array = value.As<v8::Array>();
+    for (uint32_t i = 0; i < array->Length(); ++i) {
+      v8::Local<v8::Value> layer = Nan::Get(array, i).ToLocalChecked();
+      if (!(layer->IsArrayBufferView() || layer->IsArrayBuffer() ||
+            layer->IsSharedArrayBuffer())) {
+        return false;
+      }
+      layers.push_back(GetArrayBufferContents(layer));
+    }
+    return true;
+  }
+
+  if (!value->IsObject()) {
+    return false;
+  }
+  v8::Local<v8::Object> object = value.As<v8::Object>();
+  v8::Local<v8::Value> buffer =
+      Nan::Get(object, Nan::New<v8::String>("buffer").ToLocalChecked()).ToLocalChecked();
+  v8::Local<v8::Value> offsets =
+      Nan::Get(object, Nan::New<v8::String>("offsets").ToLocalChecked()).ToLocalChecked();
+  if (!(buffer->IsArrayBufferView() || buffer->IsArrayBuffer() || buffer->IsSharedArrayBuffer()) ||
+      !(offsets->IsArray() || offsets->IsTypedArray())) {
+    return false;
+  }
+
+  ArrayBufferContents contents = GetArrayBufferContents(buffer);
+  v8::Local<v8::Object> offsetList = offsets.As<v8::Object>();
+  uint32_t count = offsets->IsArray()
+                       ? offsets.As<v8::Array>()->Length()
+                       : static_cast<uint32_t>(offsets.As<v8::TypedArray>()->Length());
+  for (uint32_t i = 0; i < count; ++i) {
+    double offset = Nan::To<double>(Nan::Get(offsetList, i).ToLocalChecked()).FromMaybe(-1);
+    if (!(offset >= 0 && offset <= contents.byteLength)) {
+      return false;
+    }
+    size_t start = static_cast<size_t>(offset);
+    layers.push_back({contents.data + start, contents.byteLength - start});
+  }
+  return true;
+}
+
+// Uploads a list of separate layer images into consecutive layers of a 2D array
+// or 3D texture with a single texSubImage3D call. Layers that are not already
+// laid out back to back in one buffer are gathered into a staging buffer that
+// is kept by the context, so repeated uploads don't allocate.
+GL_METHOD(TexSubImage3DLayers) {
+  GL_BOILERPLATE;
+  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint level = Nan::To<int32_t>(info[1]).ToChecked();
+  GLint xoffset = Nan::To<int32_t>(info[2]).ToChecked();
+  GLint yoffset = Nan::To<int32_t>(info[3]).ToChecked();
+  GLint zoffset = Nan::To<int32_t>(info[4]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[5]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[6]).ToChecked();
+  GLenum format = Nan::To<int32_t>(info[7]).ToChecked();
+  GLenum type = Nan::To<int32_t>(info[8]).ToChecked();
+
+  std::vector<ArrayBufferContents> layers;
+  if (!GetLayerContents(info[9], layers)) {
+    Nan::ThrowTypeError("Invalid layers for TexSubImage3DLayers");
+    return;
+  }
+  if (layers.empty()) {
+    return;
+  }
+
+  // Layers are client memory, which WebGL 2 doesn't allow uploading from
+  // while a pixel unpack buffer is bound
+  GLint unpackBuffer = 0;
+  glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer);
+  if (unpackBuffer != 0) {
+    inst->setError(GL_INVALID_OPERATION);
+    return;
+  }
+
+  const PixelFormatDescriptor *descriptor = FindPixelFormat(format, type, inst->webgl2);
+  if (!descriptor || width < 0 || height < 0) {
+    inst->setError(descriptor ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return;
+  }
+
+  size_t imageSize =
+      PixelImageSize(width, height, descriptor->bytesPerPixel, inst->unpack_alignment);
+  for (const ArrayBufferContents &layer : layers) {
+    if (layer.byteLength < imageSize) {
+      inst->setError(GL_INVALID_OPERATION);
+      return;
+    }
+  }
+
+  // With a non default layout GL would not read the layers where we put them,
+  // so upload them one at a time.
+  const GLenum pnames[] = {GL_UNPACK_ROW_LENGTH, GL_UNPACK_IMAGE_HEIGHT, GL_UNPACK_SKIP_PIXELS,
+                           GL_UNPACK_SKIP_ROWS, GL_UNPACK_SKIP_IMAGES};
+  for (GLenum pname : pnames) {
+    GLint value = 0;
+    glGetIntegerv(pname, &value);
+    if (value != 0) {
+      for (size_t i = 0; i < layers.size(); ++i) {
+        glTexSubImage3DRobustANGLE(target, level, xoffset, yoffset,
+                                   zoffset + static_cast<GLint>(i), width, height, 1, format, type,
+                                   layers[i].byteLength, layers[i].data);
+      }
+      return;
+    }
+  }
+
+  GLsizei depth = static_cast<GLsizei>(layers.size());
+  size_t layerStride = PixelRowStride(width, descriptor->bytesPerPixel, inst->unpack_alignment) *
+                       static_cast<size_t>(height);
+
+  // Layers that already follow each other in memory are uploaded in place
+  bool contiguous = true;
+  for (size_t i = 1; i < layers.size() && contiguous; ++i) {
+    contiguous = layers[i].data == layers[0].data + i * layerStride;
+  }
+  if (contiguous) {
+    glTexSubImage3DRobustANGLE(target, level, xoffset, yoffset, zoffset, width, height, depth,
+                               format, type, layers.back().data + imageSize - layers[0].data,
+                               layers[0].data);
+    return;
+  }
+
+  size_t stagingSize = layerStride * (layers.size() - 1) + imageSize;
+  if (inst->layerStaging.size() < stagingSize) {
+    inst->layerStaging.resize(stagingSize);
+  }
+  uint8_t *staging = inst->layerStaging.data();
+  for (size_t i = 0; i < layers.size(); ++i) {
+    memcpy(staging + i * layerStride, layers[i].data, imageSize);
+  }
+  glTexSubImage3DRobustANGLE(target, level, xoffset, yoffset, zoffset, width, height, depth,
+                             format, type, stagingSize, staging);
+}
+
 GL_METHOD(CopyTexSubImage3D) {
   GL_BOILERPLATE;
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
@@ -2459,6 +4522,7 @@ GL_METHOD(CopyTexSubImage3D) {
   GLint y = Nan::To<int32_t>(info[6]).ToChecked();
   GLsizei width = Nan::To<int32_t>(info[7]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[8]).ToChecked();
+  inst->prepareDrawingBufferRead(x, y, width, height);
   glCopyTexSubImage3D(target, level, xoffset, yoffset, zoffset, x, y, width, height);
 }
 
@@ -2707,6 +4771,7 @@ GL_METHOD(DrawArraysInstanced) {
   GLint first = Nan::To<int32_t>(info[1]).ToChecked();
   GLsizei count = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei instanceCount = Nan::To<int32_t>(info[3]).ToChecked();
+  inst->demoteSampledMipChains();
   glDrawArraysInstanced(mode, first, count, instanceCount);
 }
 
@@ -2717,6 +4782,7 @@ GL_METHOD(DrawElementsInstanced) {
   GLenum type = Nan::To<int32_t>(info[2]).ToChecked();
   GLintptr offset = Nan::To<int64_t>(info[3]).ToChecked();
   GLsizei instanceCount = Nan::To<int32_t>(info[4]).ToChecked();
+  inst->demoteSampledMipChains();
   glDrawElementsInstanced(mode, count, type, reinterpret_cast<const void *>(offset), instanceCount);
 }
 
@@ -2728,6 +4794,7 @@ GL_METHOD(DrawRangeElements) {
   GLsizei count = Nan::To<int32_t>(info[3]).ToChecked();
   GLenum type = Nan::To<int32_t>(info[4]).ToChecked();
   GLintptr offset = Nan::To<int64_t>(info[5]).ToChecked();
+  inst->demoteSampledMipChains();
   glDrawRangeElements(mode, start, end, count, type, reinterpret_cast<const void *>(offset));
 }
 
@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <set>
 #include <utility>
 #include <vector>
@@ -14,20 +15,15 @@
 #define EGL_EGL_PROTOTYPES 0
 #define GL_GLES_PROTOTYPES 0
 
+#include "GLObjectRegistry.h"
+#include "PixelFormat.h"
+#include "ProgramCache.h"
+#include "ShaderStats.h"
+#include "ShaderSource.h"
 #include "SharedLibrary.h"
 #include "angle-loader/egl_loader.h"
 #include "angle-loader/gles_loader.h"
 
-enum GLObjectType {
-  GLOBJECT_TYPE_BUFFER,
-  GLOBJECT_TYPE_FRAMEBUFFER,
-  GLOBJECT_TYPE_PROGRAM,
-  GLOBJECT_TYPE_RENDERBUFFER,
-  GLOBJECT_TYPE_SHADER,
-  GLOBJECT_TYPE_TEXTURE,
-  GLOBJECT_TYPE_VERTEX_ARRAY,
-};
-
 enum GLContextState {
   GLCONTEXT_STATE_INIT,
   GLCONTEXT_STATE_OK,
@@ -37,7 +33,50 @@ enum GLContextState {
 
 bool CaseInsensitiveCompare(const std::string &a, const std::string &b);
 
-using GLObjectReference = std::pair<GLuint, GLObjectType>;
+// A texImage2D mip chain whose GL calls are held back until it is known whether
+// it can be backed by a single immutable texture storage allocation.
+struct PendingMipLevel {
+  std::vector<uint8_t> pixels;
+  GLint alignment;
+};
+
+struct PendingMipChain {
+  GLenum internalformat;
+  GLenum sizedInternalformat;
+  GLenum format;
+  GLenum type;
+  GLsizei width;
+  GLsizei height;
+  GLsizei levelCount;
+  std::vector<PendingMipLevel> levels;
+};
+
+// The shape of a mip chain once it is backed by immutable storage, which
+// uploads of the same shape can still update in place
+struct PromotedMipChain {
+  GLenum internalformat;
+  GLenum format;
+  GLenum type;
+  GLsizei width;
+  GLsizei height;
+  GLsizei levelCount;
+};
+
+// The framebuffer that stands in for the default one. Its attachments are
+// allocated at a capacity that can be larger than the size the application
+// sees, so that resizing within it allocates nothing.
+struct DrawingBuffer {
+  GLuint framebuffer = 0;
+  GLuint color = 0;
+  GLuint depthStencil = 0;
+  bool alpha = true;
+  bool depth = true;
+  bool stencil = false;
+  GLsizei width = 0;
+  GLsizei height = 0;
+  GLsizei capacityWidth = 0;
+  GLsizei capacityHeight = 0;
+};
 using WebGLToANGLEExtensionsMap =
     std::map<std::string, std::vector<std::string>, decltype(&CaseInsensitiveCompare)>;
 
@@ -47,7 +86,35 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static bool HAS_DISPLAY;
   static EGLDisplay DISPLAY;
 
-  SharedLibrary eglLibrary;
+  // Contexts render into their drawing buffer framebuffer, so they are made
+  // current without a surface when the display supports it, and otherwise
+  // with a 1x1 pbuffer shared by all the contexts of a config
+  static bool SURFACELESS;
+
+  // Whether ANGLE's own program cache can be trimmed, with
+  // EGL_ANGLE_program_cache_control
+  static bool PROGRAM_CACHE_CONTROL;
+  static std::map<EGLConfig, EGLSurface> SHARED_SURFACES;
+  static EGLSurface SharedSurface(EGLConfig config);
+  static void DestroySharedSurfaces();
+
+  static SharedLibrary EGL_LIBRARY;
+  static bool GLES_LOADED;
+
+  // What every context of one WebGL version on the display has in common,
+  // worked out by the first of them to be created
+  struct DisplayCache {
+    bool ready = false;
+    EGLConfig config = nullptr;
+    std::set<std::string> enabledExtensions;
+    std::shared_ptr<const std::set<std::string>> requestableExtensions;
+    std::shared_ptr<const std::set<std::string>> supportedWebGLExtensions;
+    GLenum preferredDepth = 0;
+    GLint maxTextureSize = 0;
+    GLint maxTextureUnits = 0;
+  };
+  static DisplayCache DISPLAY_CACHES[2];
+  static const WebGLToANGLEExtensionsMap &WebGLToANGLEExtensions(bool webgl2);
   EGLContext context;
   EGLConfig config;
   EGLSurface surface;
@@ -60,15 +127,55 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   GLint unpack_colorspace_conversion;
   GLint unpack_alignment;
 
-  std::set<std::string> requestableExtensions;
+  std::shared_ptr<const std::set<std::string>> requestableExtensions;
   std::set<std::string> enabledExtensions;
-  std::set<std::string> supportedWebGLExtensions;
-  WebGLToANGLEExtensionsMap webGLToANGLEExtensions;
+  std::shared_ptr<const std::set<std::string>> supportedWebGLExtensions;
+  const WebGLToANGLEExtensionsMap *webGLToANGLEExtensions;
 
   // A list of object references, need do destroy them at program exit
-  std::map<std::pair<GLuint, GLObjectType>, bool> objects;
-  void registerGLObj(GLObjectType type, GLuint obj) { objects[std::make_pair(obj, type)] = true; }
-  void unregisterGLObj(GLObjectType type, GLuint obj) { objects.erase(std::make_pair(obj, type)); }
+  GLObjectRegistry objects;
+  void registerGLObj(GLObjectType type, GLuint obj) {
+    objectsOfType(type).insert(obj) = GLObjectInfo();
+  }
+  void unregisterGLObj(GLObjectType type, GLuint obj);
+
+  // Buffers, textures, renderbuffers, shaders and programs belong to the
+  // share group rather than to the context, and are only destroyed along with
+  // the last context in it. Framebuffers and vertex arrays are never shared.
+  struct ShareGroup {
+    GLObjectRegistry objects;
+    size_t bytes = 0;
+    std::map<GLuint, PromotedMipChain> promotedMipChains;
+
+    // Changes bytes, and the external memory reported to V8 along with it
+    void adjustBytes(size_t removed, size_t added);
+    ~ShareGroup();
+  };
+  std::shared_ptr<ShareGroup> shareGroup;
+  static bool IsSharedObjectType(GLObjectType type) {
+    return type != GLOBJECT_TYPE_FRAMEBUFFER && type != GLOBJECT_TYPE_VERTEX_ARRAY;
+  }
+  GLObjectSet &objectsOfType(GLObjectType type) {
+    return IsSharedObjectType(type) ? shareGroup->objects[type] : objects[type];
+  }
+  static void DeleteGLObjects(GLObjectType type, const std::vector<GLuint> &names);
+  static void DeleteGLObjects(const GLObjectRegistry &objects);
+
+  // Memory accounting. Buffers, textures and renderbuffers record the bytes
+  // they hold, which are summed over the share group. An allocation that would
+  // take the total past memoryLimit fails with OUT_OF_MEMORY instead. It is
+  // checked before the GL call that makes it, and only recorded once GL has
+  // accepted that call.
+  double memoryLimit;
+  GLuint boundObject(GLenum target);
+  bool checkAllocation(GLObjectType type, GLuint name, std::pair<GLenum, GLint> image,
+                       size_t bytes);
+  bool checkStorage(GLObjectType type, GLuint name, size_t bytes);
+  void trackAllocation(GLObjectType type, GLuint name, std::pair<GLenum, GLint> image,
+                       size_t bytes);
+  void trackStorage(GLObjectType type, GLuint name, size_t bytes);
+  void flushGLErrors();
+  bool glCallSucceeded();
 
   // Context list
   WebGLRenderingContext *next, *prev;
@@ -98,7 +205,10 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   WebGLRenderingContext(int width, int height, bool alpha, bool depth, bool stencil, bool antialias,
                         bool premultipliedAlpha, bool preserveDrawingBuffer,
                         bool preferLowPowerToHighPerformance, bool failIfMajorPerformanceCaveat,
-                        bool createWebGL2Context);
+                        bool createWebGL2Context, bool promoteTextureStorage,
+                        const std::string &programCacheDir, double programCacheMaxBytes,
+                        double programCacheMemoryBytes, WebGLRenderingContext *shareContext,
+                        double memoryLimit);
   virtual ~WebGLRenderingContext();
 
   // Context validation
@@ -106,14 +216,71 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   bool setActive();
 
   // Unpacks a buffer full of pixels into memory
+  // Returns an empty vector if the format is unknown or the buffer too short.
   std::vector<uint8_t> unpackPixels(GLenum type, GLenum format, GLint width, GLint height,
-                                    unsigned char *pixels);
+                                    const uint8_t *pixels, size_t byteLength);
+
+  // Immutable texture storage promotion. Only a context that shares its
+  // textures with no other records and promotes mip chains, so nothing it
+  // does to them has to be made visible in another context.
+  bool webgl2;
+  bool promoteTextureStorage;
+  GLint maxTextureSize;
+  std::map<GLuint, PendingMipChain> pendingMipChains;
+  // The TEXTURE_2D binding of every texture unit, and the recorded chains
+  // bound to any of them, which are the only ones a draw has to complete
+  std::vector<GLuint> textureUnits2D;
+  GLuint activeTextureUnit;
+  std::set<GLuint> sampledMipChains;
+  double promotedTextures;
+  double avoidedReallocations;
+  double demotedMipChains;
+  GLuint boundTexture2D();
+  void updateTextureUnit2D();
+  bool hasDefaultUnpackLayout();
+  bool canPromoteMipChains();
+  bool deferTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width,
+                       GLsizei height, GLint border, GLenum format, GLenum type,
+                       const uint8_t *pixels, size_t byteLength);
+  void promoteMipChain(GLuint texture, bool generateMipmap);
+  bool updatePromotedTexture(GLenum target, GLint level, GLenum internalformat, GLsizei width,
+                             GLsizei height, GLint border, GLenum format, GLenum type,
+                             const uint8_t *pixels, size_t byteLength);
+  bool copyToPromotedTexture(GLenum target, GLint level, GLenum internalformat, GLint x,
+                             GLint y, GLsizei width, GLsizei height, GLint border);
+  GLuint unpromoteBoundTexture(GLenum target);
+  GLuint unpromoteTexture(GLuint texture);
+  void replaceTexture(GLuint texture, GLuint replacement);
+  void demoteMipChain(GLuint texture);
+  void demoteBoundMipChain(GLenum target);
+  void demoteSampledMipChains();
+  void demoteAllMipChains();
+
+  // Staging memory for texSubImage3DLayers, kept between calls until
+  // trimMemory releases it
+  std::vector<uint8_t> layerStaging;
+
+  // Drawing buffer storage
+  DrawingBuffer drawingBuffer;
+  GLuint resizeDrawingBuffer(GLsizei width, GLsizei height);
+  void clearDrawingBufferOutside(GLsizei width, GLsizei height);
+  void prepareDrawingBufferRead(GLint x, GLint y, GLsizei width, GLsizei height);
+
+  // Program reflection
+  v8::Local<v8::Object> reflectProgram(GLuint program);
+
+  // Compile and link timing
+  ShaderStats shaderStats;
+  static NAN_METHOD(GetShaderStats);
 
   // Error handling
   std::set<GLenum> errorSet;
   void setError(GLenum error);
   GLenum getError();
   static NAN_METHOD(SetError);
+  static NAN_METHOD(GetPixelFormatSize);
+  static NAN_METHOD(ValidateShaderSource);
+  static NAN_METHOD(TrimProgramCache);
   static NAN_METHOD(GetError);
 
   // Preferred depth format
@@ -122,12 +289,23 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   // Destructors
   void dispose();
 
+  // Deletes the objects of the context other than those listed in keep and
+  // puts the GL state back to its defaults, so that it can be reused
+  void resetState(const std::set<GLObjectReference> &keep);
+
   static NAN_METHOD(DisposeAll);
 
   static NAN_METHOD(New);
   static NAN_METHOD(Destroy);
+  static NAN_METHOD(ResetState);
+  static NAN_METHOD(GetMemoryInfo);
+  static NAN_METHOD(DeleteObjectsBatch);
+  static NAN_METHOD(TrimMemory);
+  static NAN_METHOD(ResizeDrawingBuffer);
 
   static NAN_METHOD(VertexAttribDivisorANGLE);
+  static NAN_METHOD(MaxShaderCompilerThreadsKHR);
+  static NAN_METHOD(EnableParallelShaderCompile);
   static NAN_METHOD(DrawArraysInstancedANGLE);
   static NAN_METHOD(DrawElementsInstancedANGLE);
 
@@ -158,6 +336,8 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(CreateProgram);
   static NAN_METHOD(AttachShader);
   static NAN_METHOD(LinkProgram);
+  static NAN_METHOD(LinkAndReflect);
+  static NAN_METHOD(ReflectProgram);
   static NAN_METHOD(GetProgramParameter);
   static NAN_METHOD(GetUniformLocation);
   static NAN_METHOD(ClearColor);
@@ -264,6 +444,10 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(SampleCoverage);
   static NAN_METHOD(GetUniform);
 
+  static NAN_METHOD(GetTextureStorageStats);
+  static NAN_METHOD(UnpromoteTextures);
+  static NAN_METHOD(GetProgramCacheStats);
+
   static NAN_METHOD(DrawBuffersWEBGL);
   static NAN_METHOD(EXTWEBGL_draw_buffers);
 
@@ -286,6 +470,7 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(TexStorage3D);
   static NAN_METHOD(TexImage3D);
   static NAN_METHOD(TexSubImage3D);
+  static NAN_METHOD(TexSubImage3DLayers);
   static NAN_METHOD(CopyTexSubImage3D);
   static NAN_METHOD(CompressedTexImage3D);
   static NAN_METHOD(CompressedTexSubImage3D);
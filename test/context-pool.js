@@ -0,0 +1,116 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const { createContextPool } = createContext
+
+tape('context pool - reset on release', function (t) {
+  const pool = createContextPool({ size: 1, width: 2, height: 2 })
+
+  const gl = pool.acquire()
+  t.ok(gl, 'acquired')
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  const program = gl.createProgram()
+  gl.enable(gl.BLEND)
+  gl.blendFunc(gl.SRC_ALPHA, gl.ONE)
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.pixelStorei(gl.UNPACK_ALIGNMENT, 1)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  gl.getError()
+  pool.release(gl)
+
+  const next = pool.acquire()
+  t.equals(next, gl, 'context is reused')
+  t.equals(next.getError(), next.NO_ERROR, 'errors are cleared')
+  t.equals(next.isEnabled(next.BLEND), false, 'capabilities are reset')
+  t.equals(next.getParameter(next.BLEND_SRC_RGB), next.ONE, 'blend function is reset')
+  t.same(Array.from(next.getParameter(next.COLOR_CLEAR_VALUE)), [0, 0, 0, 0], 'clear color is reset')
+  t.equals(next.getParameter(next.UNPACK_ALIGNMENT), 4, 'pixel storage is reset')
+  t.equals(next.getParameter(next.TEXTURE_BINDING_2D), null, 'texture bindings are reset')
+
+  const pixels = new Uint8Array(16)
+  next.readPixels(0, 0, 2, 2, next.RGBA, next.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), new Array(16).fill(0), 'drawing buffer is cleared')
+
+  t.equals(next.isTexture(texture), false, 'objects are deleted')
+  next.bindTexture(next.TEXTURE_2D, texture)
+  t.equals(next.getError(), next.INVALID_VALUE, 'stale textures are rejected')
+  next.useProgram(program)
+  t.equals(next.getError(), next.INVALID_VALUE, 'stale programs are rejected')
+
+  next.bindTexture(next.TEXTURE_2D, next.createTexture())
+  t.equals(next.getError(), next.NO_ERROR, 'new objects work')
+
+  pool.destroy()
+  t.end()
+})
+
+tape('context pool - sizes', function (t) {
+  const pool = createContextPool({ size: 1, width: 4, height: 4 })
+
+  const a = pool.acquire(8, 2)
+  t.equals(a.drawingBufferWidth, 8, 'resized on acquire')
+  t.equals(a.drawingBufferHeight, 2, 'resized on acquire')
+  const b = pool.acquire()
+  t.ok(b && b !== a, 'creates contexts once empty')
+
+  pool.release(a)
+  pool.release(b)
+  t.throws(() => pool.release(b), TypeError, 'released twice')
+  t.equals(pool.acquire(), a, 'keeps size contexts')
+
+  t.throws(() => createContextPool({ width: 0, height: 1 }), TypeError, 'invalid size')
+  t.throws(() => createContextPool({ width: 1, height: 1, attributes: { shareWith: a } }), TypeError,
+    'shared contexts')
+  pool.destroy()
+  t.end()
+})
+
+tape('context pool - contexts shared with later', function (t) {
+  const pool = createContextPool({ size: 1, width: 4, height: 4 })
+
+  const a = pool.acquire()
+  const other = createContext(1, 1, { shareWith: a })
+  const buffer = a.createBuffer()
+  a.bindBuffer(a.ARRAY_BUFFER, buffer)
+  pool.release(a)
+  t.ok(other.isBuffer(buffer), 'shared objects survive the release')
+  t.notEqual(pool.acquire(), a, 'shared context not reused')
+
+  other.destroy()
+  pool.destroy()
+  t.end()
+})
+
+tape('context pool - warm programs are kept', function (t) {
+  const warmPrograms = [
+    { id: 'solid', vertex: 'attribute vec4 position; void main() { gl_Position = position; }', fragment: 'void main() { gl_FragColor = vec4(1); }' },
+    { id: 'deleted', vertex: 'void main() { gl_Position = vec4(0); }', fragment: 'void main() { gl_FragColor = vec4(0); }' }
+  ]
+  const pool = createContextPool({ size: 1, width: 2, height: 2, attributes: { warmPrograms } })
+
+  const gl = pool.acquire()
+  const solid = gl.getWarmProgram('solid')
+  const deleted = gl.getWarmProgram('deleted')
+  gl.useProgram(solid)
+  gl.deleteProgram(deleted)
+  pool.release(gl)
+
+  const next = pool.acquire()
+  t.equals(next.getWarmProgram('solid'), solid, 'same program')
+  t.equals(next.getProgramParameter(solid, next.LINK_STATUS), true, 'still linked')
+  t.equals(next.getAttachedShaders(solid).length, 2, 'shaders kept')
+  t.equals(next.getParameter(next.CURRENT_PROGRAM), null, 'no longer in use')
+  next.useProgram(solid)
+  t.equals(next.getError(), next.NO_ERROR, 'usable')
+
+  const rebuilt = next.getWarmProgram('deleted')
+  t.ok(rebuilt && rebuilt !== deleted, 'deleted program built again')
+  t.equals(next.getProgramParameter(rebuilt, next.LINK_STATUS), true, 'linked')
+  t.equals(next.getError(), next.NO_ERROR, 'no errors')
+
+  pool.destroy()
+  t.end()
+})
@@ -9,3 +9,27 @@ tape('create context', function (t) {
   createContext(width, height)
   t.end()
 })
+
+tape('create context - many contexts', function (t) {
+  const contexts = []
+  for (let i = 0; i < 64; ++i) {
+    const gl = createContext(4, 4)
+    gl.clearColor(i / 255, 0, 0, 1)
+    gl.clear(gl.COLOR_BUFFER_BIT)
+    contexts.push(gl)
+  }
+
+  const pixel = new Uint8Array(4)
+  for (let i = 0; i < contexts.length; ++i) {
+    contexts[i].readPixels(0, 0, 1, 1, contexts[i].RGBA, contexts[i].UNSIGNED_BYTE, pixel)
+    if (pixel[0] !== i) {
+      t.fail('context ' + i + ' lost its drawing buffer')
+    }
+  }
+  t.pass('each context keeps its drawing buffer')
+
+  for (const gl of contexts) {
+    gl.destroy()
+  }
+  t.end()
+})
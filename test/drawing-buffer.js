@@ -0,0 +1,67 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function offscreenTarget (gl) {
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  return framebuffer
+}
+
+tape('drawing buffer - allocated on first use', function (t) {
+  const gl = createContext(64, 64)
+  t.equals(gl.getMemoryInfo().drawingBufferBytes, 0, 'not allocated by createContext')
+
+  offscreenTarget(gl)
+  gl.clearColor(0, 1, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [0, 255, 0, 255], 'offscreen rendering')
+  t.equals(gl.getMemoryInfo().drawingBufferBytes, 0, 'not allocated by offscreen rendering')
+
+  gl.resize(8, 8)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  t.equals(gl.getMemoryInfo().drawingBufferBytes, 0, 'not allocated by binding it')
+
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [0, 0, 0, 0], 'starts out cleared')
+  t.ok(gl.getMemoryInfo().drawingBufferBytes >= 8 * 8 * 4, 'allocated at the new size')
+  t.equals(gl.checkFramebufferStatus(gl.FRAMEBUFFER), gl.FRAMEBUFFER_COMPLETE, 'complete')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no error')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('drawing buffer - queried before use', function (t) {
+  const gl = createContext(16, 16)
+  t.equals(gl.getParameter(gl.ALPHA_BITS), 8, 'alpha bits')
+  t.ok(gl.getMemoryInfo().drawingBufferBytes > 0, 'allocated')
+  gl.destroy()
+  t.end()
+})
+
+tape('drawing buffer - disabled', function (t) {
+  const gl = createContext(64, 64, { drawingBuffer: false })
+
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  t.equals(gl.getError(), gl.INVALID_FRAMEBUFFER_OPERATION, 'default framebuffer unusable')
+  t.notEqual(gl.checkFramebufferStatus(gl.FRAMEBUFFER), gl.FRAMEBUFFER_COMPLETE, 'incomplete')
+  t.equals(gl.getMemoryInfo().drawingBufferBytes, 0, 'never allocated')
+
+  offscreenTarget(gl)
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [255, 0, 0, 255], 'offscreen rendering')
+
+  gl.destroy()
+  t.end()
+})
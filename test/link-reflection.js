@@ -0,0 +1,99 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const { attachShaders } = require('./util/make-program')
+
+tape('link reflection - attributes and uniforms', function (t) {
+  const gl = createContext(1, 1)
+
+  const program = attachShaders(gl, `
+attribute vec2 position;
+attribute vec4 color;
+varying vec4 vColor;
+uniform vec2 offset;
+void main() {
+  vColor = color;
+  gl_Position = vec4(position + offset, 0.0, 1.0);
+}`, `
+precision mediump float;
+varying vec4 vColor;
+uniform float alpha[2];
+void main() {
+  gl_FragColor = vColor * alpha[0] * alpha[1];
+}`)
+  gl.linkProgram(program)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'linked')
+  t.equals(gl.getProgramParameter(program, gl.ACTIVE_ATTRIBUTES), 2, 'active attributes')
+  t.equals(gl.getProgramParameter(program, gl.ACTIVE_UNIFORMS), 2, 'active uniforms')
+
+  const locations = ['position', 'color'].map((name) => gl.getAttribLocation(program, name))
+  t.ok(locations.every((location) => location >= 0), 'attribute locations')
+
+  const uniforms = new Set()
+  for (let i = 0; i < 2; ++i) {
+    const info = gl.getActiveUniform(program, i)
+    uniforms.add(info.name)
+    if (info.name.indexOf('alpha') === 0) {
+      t.equals(info.size, 2, 'array size')
+    }
+  }
+  t.ok(uniforms.has('offset') && uniforms.has('alpha[0]'), 'uniform names')
+
+  gl.linkProgram(program)
+  t.same(['position', 'color'].map((name) => gl.getAttribLocation(program, name)), locations,
+    'relinking keeps attribute locations')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('link reflection - link failures', function (t) {
+  const gl = createContext(1, 1)
+
+  const program = attachShaders(gl, `
+varying vec3 value;
+void main() {
+  gl_Position = vec4(value, 1.0);
+}`, `
+precision mediump float;
+varying vec4 value;
+void main() {
+  gl_FragColor = value;
+}`)
+  gl.linkProgram(program)
+  t.notOk(gl.getProgramParameter(program, gl.LINK_STATUS), 'link failed')
+  t.ok(gl.getProgramInfoLog(program).length > 0, 'info log')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('link reflection - uniform blocks', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+
+  const program = attachShaders(gl, `#version 300 es
+in vec2 position;
+uniform Transform {
+  vec2 offset;
+  vec2 scale;
+};
+void main() {
+  gl_Position = vec4(position * scale + offset, 0.0, 1.0);
+}`, `#version 300 es
+precision mediump float;
+out vec4 color;
+void main() {
+  color = vec4(1.0);
+}`)
+  gl.linkProgram(program)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'linked')
+  t.equals(gl.getProgramParameter(program, gl.ACTIVE_UNIFORM_BLOCKS), 1, 'active uniform blocks')
+  t.equals(gl.getActiveUniformBlockName(program, 0), 'Transform', 'block name')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
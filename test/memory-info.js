@@ -0,0 +1,111 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+tape('memory info - accounting', function (t) {
+  const gl = createContext(16, 16)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+
+  const empty = gl.getMemoryInfo()
+  t.equals(empty.textures.count, 0, 'drawing buffer is not counted as a texture')
+  t.equals(empty.drawingBufferBytes > 0, true, 'drawing buffer')
+  t.equals(empty.limit, Infinity, 'no limit')
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, 1024, gl.STATIC_DRAW)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array(512), gl.STATIC_DRAW)
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 8, 8, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  gl.texImage2D(gl.TEXTURE_2D, 1, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGB, 8, 8, 0, gl.RGB, gl.UNSIGNED_BYTE, null)
+
+  const renderbuffer = gl.createRenderbuffer()
+  gl.bindRenderbuffer(gl.RENDERBUFFER, renderbuffer)
+  gl.renderbufferStorage(gl.RENDERBUFFER, gl.RGBA4, 10, 10)
+
+  const info = gl.getMemoryInfo()
+  t.same(info.buffers, { count: 2, bytes: 2048 }, 'buffers, including the attribute 0 buffer')
+  t.same(info.textures, { count: 1, bytes: 8 * 8 * 3 + 4 * 4 * 4 }, 'texture levels')
+  t.same(info.renderbuffers, { count: 1, bytes: 200 }, 'renderbuffers')
+  t.equals(info.totalBytes, 2048 + 256 + 192 + 200 + empty.drawingBufferBytes, 'total')
+
+  gl.deleteBuffer(buffer)
+  gl.deleteTexture(texture)
+  t.equals(gl.getMemoryInfo().totalBytes, 200 + empty.drawingBufferBytes, 'deleted objects')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('memory info - limit', function (t) {
+  const gl = createContext(4, 4, { memoryLimit: 64 * 1024 })
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, 16 * 1024, gl.STATIC_DRAW)
+  t.equals(gl.getError(), gl.NO_ERROR, 'under the limit')
+
+  gl.bufferData(gl.ARRAY_BUFFER, 128 * 1024, gl.STATIC_DRAW)
+  t.equals(gl.getError(), gl.OUT_OF_MEMORY, 'over the limit')
+  t.equals(gl.getBufferParameter(gl.ARRAY_BUFFER, gl.BUFFER_SIZE), 16 * 1024, 'buffer unchanged')
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 256, 256, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.OUT_OF_MEMORY, 'texture over the limit')
+
+  gl.bufferData(gl.ARRAY_BUFFER, 0, gl.STATIC_DRAW)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 64, 64, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.NO_ERROR, 'freed memory can be reused')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('memory info - rejected calls', function (t) {
+  const gl = createContext(4, 4)
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 8, 8, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  const before = gl.getMemoryInfo()
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 64, 64, 1, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'rejected by GL')
+  t.same(gl.getMemoryInfo(), before, 'accounting unchanged')
+  gl.destroy()
+
+  const gl2 = createContext(4, 4, { createWebGL2Context: true })
+  if (gl2) {
+    const immutable = gl2.createTexture()
+    gl2.bindTexture(gl2.TEXTURE_2D, immutable)
+    gl2.texStorage2D(gl2.TEXTURE_2D, 1, gl2.RGBA8, 8, 8)
+    const stored = gl2.getMemoryInfo()
+    gl2.texStorage2D(gl2.TEXTURE_2D, 1, gl2.RGBA8, 64, 64)
+    gl2.texImage2D(gl2.TEXTURE_2D, 0, gl2.RGBA, 64, 64, 0, gl2.RGBA, gl2.UNSIGNED_BYTE, null)
+    t.equals(gl2.getError(), gl2.INVALID_OPERATION, 'immutable storage')
+    t.same(gl2.getMemoryInfo(), stored, 'immutable texture accounting unchanged')
+    gl2.destroy()
+  }
+
+  t.end()
+})
+
+tape('memory info - external memory', function (t) {
+  const size = 32 * 1024 * 1024
+  const before = process.memoryUsage().external
+  const gl = createContext(16, 16)
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, size, gl.STATIC_DRAW)
+  const allocated = process.memoryUsage().external
+  t.ok(allocated - before >= size, 'allocation reported to V8')
+
+  gl.destroy()
+  t.ok(allocated - process.memoryUsage().external >= size, 'release reported to V8')
+  t.end()
+})
@@ -0,0 +1,139 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const { attachShaders } = require('./util/make-program')
+
+const VERTEX_SHADER = `
+attribute vec2 position;
+void main() {
+  gl_Position = vec4(position, 0.0, 1.0);
+}`
+
+function fragmentShader (index) {
+  return `
+precision mediump float;
+uniform vec4 color${index};
+void main() {
+  gl_FragColor = color${index};
+}`
+}
+
+tape('linkProgramAsync - many programs', function (t) {
+  const gl = createContext(1, 1)
+
+  const programs = []
+  for (let i = 0; i < 16; ++i) {
+    programs.push(attachShaders(gl, VERTEX_SHADER, fragmentShader(i)))
+  }
+
+  Promise.all(programs.map((program) => gl.linkProgramAsync(program))).then(function (statuses) {
+    t.ok(statuses.every(Boolean), 'all programs linked')
+    programs.forEach(function (program, i) {
+      t.ok(gl.getUniformLocation(program, 'color' + i), 'program ' + i + ' reflected')
+    })
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+    gl.destroy()
+    t.end()
+  })
+})
+
+tape('linkProgramAsync - pending links are polled together', function (t) {
+  const gl = createContext(1, 1)
+
+  const programs = []
+  for (let i = 0; i < 8; ++i) {
+    programs.push(attachShaders(gl, VERTEX_SHADER, fragmentShader(i)))
+  }
+
+  const realSetImmediate = global.setImmediate
+  let scheduled = 0
+  global.setImmediate = function () {
+    scheduled += 1
+    return realSetImmediate.apply(this, arguments)
+  }
+  const pending = programs.map((program) => gl.linkProgramAsync(program))
+  global.setImmediate = realSetImmediate
+  t.equals(scheduled, 1, 'one poll scheduled for every program')
+
+  Promise.all(pending).then(function (statuses) {
+    t.ok(statuses.every(Boolean), 'all programs linked')
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+    gl.destroy()
+    t.end()
+  })
+})
+
+tape('linkProgramAsync - link errors', function (t) {
+  const gl = createContext(1, 1)
+
+  const program = attachShaders(gl, VERTEX_SHADER, 'this is not glsl')
+  gl.linkProgramAsync(program).then(function (status) {
+    t.equals(status, false, 'link failed')
+    t.ok(gl.getProgramInfoLog(program).length > 0, 'info log')
+    gl.destroy()
+    t.end()
+  })
+})
+
+tape('linkProgramAsync - synchronous queries wait for the link', function (t) {
+  const gl = createContext(1, 1)
+
+  const program = attachShaders(gl, VERTEX_SHADER, fragmentShader(0))
+  const pending = gl.linkProgramAsync(program)
+  t.equals(gl.getProgramParameter(program, gl.LINK_STATUS), true, 'link status')
+  t.equals(gl.getProgramParameter(program, gl.ACTIVE_UNIFORMS), 1, 'active uniforms')
+
+  const ext = gl.getExtension('KHR_parallel_shader_compile')
+  if (ext) {
+    t.equals(gl.getProgramParameter(program, ext.COMPLETION_STATUS_KHR), true, 'completion status')
+  }
+
+  pending.then(function (status) {
+    t.equals(status, true, 'promise resolved')
+    gl.destroy()
+    t.end()
+  })
+})
+
+tape('linkProgramAsync - deleting the program before the link completes', function (t) {
+  const gl = createContext(1, 1)
+
+  const program = attachShaders(gl, VERTEX_SHADER, fragmentShader(0))
+  const pending = gl.linkProgramAsync(program)
+  gl.deleteProgram(program)
+
+  pending.then(function (status) {
+    t.equals(status, false, 'resolves as not linked')
+    t.equals(gl.getError(), gl.NO_ERROR, 'polling leaves no errors')
+    t.notOk('khr_parallel_shader_compile' in gl._extensions, 'extension not enabled for the app')
+    gl.destroy()
+    t.end()
+  })
+})
+
+tape('warmPrograms - programs are prepared with the context', function (t) {
+  const gl = createContext(1, 1, {
+    warmPrograms: [
+      { id: 'solid', vertex: VERTEX_SHADER, fragment: fragmentShader(0), attributes: { position: 3 } },
+      { id: 'broken', vertex: VERTEX_SHADER, fragment: 'this is not glsl' }
+    ]
+  })
+
+  const solid = gl.getWarmProgram('solid')
+  t.ok(solid, 'warm program')
+  t.equals(gl.getProgramParameter(solid, gl.LINK_STATUS), true, 'linked')
+  t.equals(gl.getAttribLocation(solid, 'position'), 3, 'attribute binding')
+  t.ok(gl.getUniformLocation(solid, 'color0'), 'reflected')
+
+  t.equals(gl.getProgramParameter(gl.getWarmProgram('broken'), gl.LINK_STATUS), false, 'link errors')
+  t.equals(gl.getWarmProgram('missing'), null, 'unknown id')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  t.throws(function () {
+    createContext(1, 1, { warmPrograms: [{ id: 'nothing' }] })
+  }, TypeError, 'invalid manifest')
+
+  gl.destroy()
+  t.end()
+})
@@ -0,0 +1,55 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function readTexture (gl, texture, width, height) {
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  const pixels = new Uint8Array(width * height * 4)
+  gl.readPixels(0, 0, width, height, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  gl.deleteFramebuffer(framebuffer)
+  return pixels
+}
+
+tape('pixel formats - flip and premultiply', function (t) {
+  const gl = createContext(2, 2)
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.NEAREST)
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, true)
+  gl.pixelStorei(gl.UNPACK_PREMULTIPLY_ALPHA_WEBGL, true)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 1, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array([
+    255, 255, 255, 255,
+    200, 100, 50, 0
+  ]))
+  t.equals(gl.getError(), gl.NO_ERROR, 'uploaded')
+  t.same(Array.from(readTexture(gl, texture, 1, 2)), [
+    0, 0, 0, 0,
+    255, 255, 255, 255
+  ], 'rows flipped and alpha premultiplied')
+
+  // The last row of a short upload is not padded to the unpack alignment
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGB, 1, 2, 0, gl.RGB, gl.UNSIGNED_BYTE, new Uint8Array(4 + 3))
+  t.equals(gl.getError(), gl.NO_ERROR, 'unpadded last row')
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGB, 1, 2, 0, gl.RGB, gl.UNSIGNED_BYTE, new Uint8Array(4 + 2))
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'short buffer')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('pixel formats - readPixels destination size', function (t) {
+  const gl = createContext(2, 2)
+
+  gl.readPixels(0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(16))
+  t.equals(gl.getError(), gl.NO_ERROR, 'large enough')
+  gl.readPixels(0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(15))
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'too small')
+
+  gl.destroy()
+  t.end()
+})
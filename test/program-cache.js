@@ -0,0 +1,110 @@
+'use strict'
+
+const tape = require('tape')
+const childProcess = require('child_process')
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const createContext = require('../index')
+const setupShader = require('./util/make-program')
+
+const VERTEX_SHADER = `
+attribute vec2 position;
+void main() {
+  gl_Position = vec4(position, 0.0, 1.0);
+}`
+
+const FRAGMENT_SHADER = `
+precision mediump float;
+uniform vec4 color;
+void main() {
+  gl_FragColor = color;
+}`
+
+function linkProgram (gl, fragmentShader = FRAGMENT_SHADER) {
+  const program = setupShader(gl, VERTEX_SHADER, fragmentShader)
+  return gl.getProgramParameter(program, gl.LINK_STATUS)
+}
+
+tape('program cache - binaries are stored and reused', function (t) {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'headless-gl-program-cache-'))
+
+  const first = createContext(1, 1, { programCache: { dir } })
+  const stats = first.getProgramCacheStats()
+  t.ok(stats.enabled, 'cache installed')
+  t.equals(stats.dir, dir, 'cache directory')
+
+  t.ok(linkProgram(first), 'first link')
+  const written = first.getProgramCacheStats()
+  t.ok(written.writes > 0, 'binaries written')
+  t.ok(written.bytes > 0, 'bytes accounted')
+  t.ok(fs.readdirSync(dir).some((name) => name.endsWith('.bin')), 'entries on disk')
+  t.notOk(fs.readdirSync(dir).some((name) => name.endsWith('.tmp')), 'no partial entries')
+  first.destroy()
+
+  const second = createContext(1, 1)
+  t.ok(linkProgram(second), 'second link')
+  t.ok(second.getProgramCacheStats().hits > written.hits, 'binaries reused')
+  second.destroy()
+
+  t.end()
+})
+
+tape('program cache - contexts share programs in memory', function (t) {
+  // Unique source, so no other test has linked this program yet
+  const fragmentShader = FRAGMENT_SHADER.replace('color;\n}', 'color * ' + Math.random().toFixed(6) + ';\n}')
+
+  const first = createContext(1, 1, { programCache: true })
+  t.ok(linkProgram(first, fragmentShader), 'first link')
+  const stats = first.getProgramCacheStats()
+  t.ok(stats.enabled, 'cache installed')
+  t.ok(stats.memoryBytes > 0, 'entries in memory')
+
+  const second = createContext(1, 1, { programCache: true })
+  t.ok(linkProgram(second, fragmentShader), 'second link')
+  const shared = second.getProgramCacheStats()
+  t.ok(shared.hits > stats.hits, 'program reused')
+  t.ok(shared.savedMs >= 0, 'saved time')
+
+  first.destroy()
+  second.destroy()
+  t.end()
+})
+
+tape('program cache - processes share a directory', function (t) {
+  // The cache is process-wide, so this process keeps the directory of the
+  // first context that asked for one
+  const gl = createContext(1, 1, {
+    programCache: { dir: fs.mkdtempSync(path.join(os.tmpdir(), 'headless-gl-program-cache-')) }
+  })
+  const dir = gl.getProgramCacheStats().dir
+
+  // Temporary files of another process: one left long ago, and one it may
+  // still be writing
+  const old = Date.now() / 1000 - 3600
+  const stale = path.join(dir, '0000000000000000.bin.999999.0.tmp')
+  const recent = path.join(dir, '0000000000000001.bin.999999.1.tmp')
+  fs.writeFileSync(stale, 'x')
+  fs.utimesSync(stale, old, old)
+  fs.writeFileSync(recent, 'x')
+
+  const fragmentShader = FRAGMENT_SHADER.replace('color;\n}', 'color * ' + Math.random().toFixed(6) + ';\n}')
+  const child = childProcess.spawnSync(process.execPath, ['-e', `
+    const createContext = require(${JSON.stringify(path.join(__dirname, '..'))})
+    const gl = createContext(1, 1, { programCache: { dir: ${JSON.stringify(dir)} } })
+    const setupShader = require(${JSON.stringify(path.join(__dirname, 'util', 'make-program'))})
+    const program = setupShader(gl, ${JSON.stringify(VERTEX_SHADER)}, ${JSON.stringify(fragmentShader)})
+    process.exit(gl.getProgramParameter(program, gl.LINK_STATUS) ? 0 : 1)
+  `])
+  t.equals(child.status, 0, 'linked in another process')
+  t.notOk(fs.existsSync(stale), 'stale temporary file swept')
+  t.ok(fs.existsSync(recent), 'recent temporary file of another process kept')
+  fs.unlinkSync(recent)
+
+  const hits = gl.getProgramCacheStats().hits
+  t.ok(linkProgram(gl, fragmentShader), 'linked here')
+  t.ok(gl.getProgramCacheStats().hits > hits, 'entry written by the other process reused')
+
+  gl.destroy()
+  t.end()
+})
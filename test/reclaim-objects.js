@@ -0,0 +1,85 @@
+'use strict'
+
+const tape = require('tape')
+const v8 = require('v8')
+const vm = require('vm')
+const createContext = require('../index')
+
+v8.setFlagsFromString('--expose-gc')
+const gc = vm.runInNewContext('gc')
+
+// Finalizers run in a task of their own after the collection
+async function collect () {
+  for (let i = 0; i < 3; ++i) {
+    gc()
+    await new Promise((resolve) => setTimeout(resolve, 10))
+  }
+}
+
+function dropTextures (gl, count) {
+  for (let i = 0; i < count; ++i) {
+    const texture = gl.createTexture()
+    gl.bindTexture(gl.TEXTURE_2D, texture)
+    gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  }
+  gl.bindTexture(gl.TEXTURE_2D, null)
+}
+
+tape('reclaim objects - dropped wrappers', async function (t) {
+  const gl = createContext(4, 4, { reclaimObjects: true })
+
+  const kept = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, kept)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  dropTextures(gl, 50)
+  t.equals(gl.getMemoryInfo().textures.count, 51, 'textures before collection')
+
+  const renderbuffer = gl.createRenderbuffer()
+  gl.bindRenderbuffer(gl.RENDERBUFFER, renderbuffer)
+  gl.renderbufferStorage(gl.RENDERBUFFER, gl.RGBA4, 4, 4)
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferRenderbuffer(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.RENDERBUFFER, renderbuffer)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  gl.bindRenderbuffer(gl.RENDERBUFFER, null)
+
+  await collect()
+  t.equals(gl.getMemoryInfo().textures.count, 51, 'nothing deleted before a frame boundary')
+  gl.flush()
+
+  const info = gl.getMemoryInfo()
+  t.equals(info.textures.count, 1, 'dropped textures deleted')
+  t.equals(info.textures.bytes, 64, 'reachable texture kept')
+  t.equals(info.renderbuffers.count, 1, 'attached renderbuffer kept')
+  t.equals(gl.getTextureMemoryStats().residentBytes, 64, 'budget updated')
+  t.equals(gl.isTexture(kept), true, 'kept texture still valid')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no error')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('reclaim objects - explicit deletes', async function (t) {
+  const gl = createContext(4, 4, { reclaimObjects: true })
+
+  gl.deleteTexture(gl.createTexture())
+  const replacement = gl.createTexture()
+  await collect()
+  gl.finish()
+  t.equals(gl.isTexture(replacement), true, 'reused name not deleted')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('reclaim objects - off by default', async function (t) {
+  const gl = createContext(4, 4)
+
+  dropTextures(gl, 10)
+  await collect()
+  gl.flush()
+  t.equals(gl.getMemoryInfo().textures.count, 10, 'dropped textures kept')
+
+  gl.destroy()
+  t.end()
+})
@@ -46,3 +46,45 @@ tape('resize', function (t) {
 
   t.end()
 })
+
+tape('resize - within capacity', function (t) {
+  const gl = createContext(64, 64)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const bytes = gl.getMemoryInfo().drawingBufferBytes
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  const renderbuffer = gl.createRenderbuffer()
+  gl.bindRenderbuffer(gl.RENDERBUFFER, renderbuffer)
+
+  gl.resize(48, 40)
+  t.equals(gl.getMemoryInfo().drawingBufferBytes, bytes, 'shrinking keeps the storage')
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), texture, 'texture binding kept')
+  t.equals(gl.getParameter(gl.RENDERBUFFER_BINDING), renderbuffer, 'renderbuffer binding kept')
+  t.equals(gl.getParameter(gl.FRAMEBUFFER_BINDING), null, 'framebuffer binding kept')
+
+  // Clearing without a scissor also fills the storage past the new size,
+  // which must still read as zero
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const pixels = new Uint8Array(50 * 42 * 4)
+  gl.readPixels(0, 0, 50, 42, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels.subarray(0, 4)), [255, 0, 0, 255], 'in bounds')
+  t.same(Array.from(pixels.subarray(48 * 4, 49 * 4)), [0, 0, 0, 0], 'right of the drawing buffer')
+  t.same(Array.from(pixels.subarray(40 * 50 * 4, 40 * 50 * 4 + 4)), [0, 0, 0, 0],
+    'above the drawing buffer')
+
+  gl.resize(64, 64)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels.subarray(0, 4)), [0, 0, 0, 0], 'cleared by resizing')
+
+  gl.resize(65, 64)
+  const grown = gl.getMemoryInfo().drawingBufferBytes
+  t.ok(grown > bytes, 'growing reallocates')
+  gl.resize(100, 64)
+  t.equals(gl.getMemoryInfo().drawingBufferBytes, grown, 'with room to grow')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no error')
+
+  gl.destroy()
+  t.end()
+})
@@ -0,0 +1,38 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+tape('shaderSource - character validation', function (t) {
+  const gl = createContext(1, 1)
+  const shader = gl.createShader(gl.FRAGMENT_SHADER)
+
+  const accepted = [
+    'void main() {}',
+    '// it\'s a comment\nvoid main() {}',
+    'void main() {} /* "quoted" @ $ */',
+    'void main() { float x = 1.0 / 2.0; }',
+    'void main() {} /* unterminated \'',
+    // Long enough to take the vectorized path before the comment
+    'void main() { gl_FragColor = vec4(1.0, 1.0, 1.0, 1.0); } // `done`'
+  ]
+  for (const source of accepted) {
+    gl.shaderSource(shader, source)
+    t.equals(gl.getError(), gl.NO_ERROR, 'accepted: ' + JSON.stringify(source))
+  }
+
+  const rejected = [
+    'void main() { $x; }',
+    'void main() {} /* closed */ "',
+    '// comment\n@',
+    'void main() { gl_FragColor = vec4(1.0, 1.0, 1.0, 1.0); } \\',
+    'void main() {}\0'
+  ]
+  for (const source of rejected) {
+    gl.shaderSource(shader, source)
+    t.equals(gl.getError(), gl.INVALID_VALUE, 'rejected: ' + JSON.stringify(source))
+  }
+
+  gl.destroy()
+  t.end()
+})
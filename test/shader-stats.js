@@ -0,0 +1,68 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const setupShader = require('./util/make-program')
+
+const VERTEX_SHADER = `
+attribute vec2 position;
+void main() {
+  gl_Position = vec4(position, 0.0, 1.0);
+}`
+
+const FRAGMENT_SHADER = `
+precision mediump float;
+void main() {
+  gl_FragColor = vec4(1.0);
+}`
+
+tape('getShaderStats - compiles and links grouped by source', function (t) {
+  const gl = createContext(1, 1)
+
+  const first = setupShader(gl, VERTEX_SHADER, FRAGMENT_SHADER)
+  const second = setupShader(gl, VERTEX_SHADER, FRAGMENT_SHADER)
+  const stats = gl.getShaderStats()
+
+  t.equals(stats.shaders.length, 2, 'one entry per shader source')
+  for (const entry of stats.shaders) {
+    t.equals(entry.count, 2, 'compiled twice')
+    t.equals(entry.shaders.length, 2, 'live shaders')
+    t.ok(entry.totalMs >= entry.maxMs && entry.maxMs >= 0, 'timings')
+    t.ok(/^[0-9a-f]{16}$/.test(entry.hash), 'hash')
+  }
+  t.same(stats.shaders.map((entry) => entry.type).sort(), [gl.FRAGMENT_SHADER, gl.VERTEX_SHADER].sort(), 'types')
+  t.same(stats.shaders.map((entry) => entry.sourceBytes).sort(),
+    [VERTEX_SHADER.length, FRAGMENT_SHADER.length].sort(), 'source sizes')
+
+  t.equals(stats.programs.length, 1, 'one entry per program source')
+  t.equals(stats.programs[0].count, 2, 'linked twice')
+  t.same(stats.programs[0].programs, [first, second], 'live programs')
+  t.equals(typeof stats.histograms, 'object', 'histograms')
+
+  gl.deleteProgram(second)
+  t.same(gl.getShaderStats().programs[0].programs, [first], 'deleted programs are dropped')
+  t.equals(gl.getShaderStats().programs[0].count, 2, 'history is kept')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('getShaderStats - entries of deleted shaders are capped', function (t) {
+  const gl = createContext(1, 1)
+
+  const kept = gl.createShader(gl.FRAGMENT_SHADER)
+  gl.shaderSource(kept, FRAGMENT_SHADER)
+  for (let i = 0; i < 1100; ++i) {
+    const shader = gl.createShader(gl.VERTEX_SHADER)
+    gl.shaderSource(shader, VERTEX_SHADER + '\n// ' + i)
+    gl.deleteShader(shader)
+  }
+
+  const stats = gl.getShaderStats()
+  t.equals(stats.shaders.length, 1024, 'capped')
+  t.ok(stats.shaders.some((entry) => entry.shaders.includes(kept)), 'live shaders kept')
+  t.ok(stats.shaders.every((entry) => entry.type === gl.VERTEX_SHADER || entry.type === gl.FRAGMENT_SHADER), 'types')
+
+  gl.destroy()
+  t.end()
+})
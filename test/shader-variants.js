@@ -0,0 +1,127 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const { MAX_VARIANTS } = require('../src/javascript/shader-variants')
+
+const VERTEX_SHADER = `
+attribute vec2 position;
+void main() {
+  gl_Position = vec4(position, 0.0, 1.0);
+}`
+
+const FRAGMENT_SHADER = `
+precision mediump float;
+void main() {
+#ifdef RED
+  gl_FragColor = vec4(1.0, 0.0, 0.0, 1.0);
+#else
+  gl_FragColor = vec4(0.0, 0.0, 1.0, 1.0);
+#endif
+#ifdef ALPHA
+  gl_FragColor.a = ALPHA;
+#endif
+}`
+
+function register (gl) {
+  gl.registerShaderTemplate('quad', {
+    vertex: VERTEX_SHADER,
+    fragment: FRAGMENT_SHADER,
+    attributes: { position: 0 },
+    features: ['RED', 'ALPHA']
+  })
+}
+
+tape('shader variants - cache keys', function (t) {
+  const gl = createContext(1, 1)
+  register(gl)
+
+  const red = gl.getVariant('quad', { RED: true, ALPHA: '0.5' })
+  t.ok(red, 'built variant')
+  t.equals(gl.getProgramParameter(red, gl.LINK_STATUS), true, 'variant is linked')
+  t.equals(gl.getAttribLocation(red, 'position'), 0, 'attributes are bound')
+  t.equals(gl.getVariant('quad', { ALPHA: '0.5', RED: true }), red, 'order does not matter')
+
+  const blue = gl.getVariant('quad', { RED: false })
+  t.notEqual(blue, red, 'distinct variant')
+  t.equals(gl.getVariant('quad'), blue, 'false toggles are left out')
+
+  t.throws(() => gl.getVariant('quad', { GREEN: true }), TypeError, 'unknown feature')
+  t.throws(() => gl.getVariant('quad', { ALPHA: {} }), TypeError, 'invalid value')
+  t.equals(gl.getVariant('missing'), null, 'unknown template')
+  t.throws(() => gl.registerShaderTemplate('bad', { vertex: VERTEX_SHADER }), TypeError, 'missing source')
+
+  gl.deleteProgram(red)
+  const rebuilt = gl.getVariant('quad', { RED: true, ALPHA: '0.5' })
+  t.notEqual(rebuilt, red, 'deleted variant is rebuilt')
+  t.equals(gl.getProgramParameter(rebuilt, gl.LINK_STATUS), true, 'rebuilt variant is linked')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('shader variants - async', function (t) {
+  const gl = createContext(1, 1)
+  register(gl)
+
+  gl.getVariantAsync('quad', { RED: true }).then(function (program) {
+    t.equals(gl.getProgramParameter(program, gl.LINK_STATUS), true, 'linked')
+    t.equals(gl.getVariant('quad', { RED: true }), program, 'shares the cache')
+    return gl.getVariantAsync('missing')
+  }).then(function (program) {
+    t.equals(program, null, 'unknown template')
+    gl.destroy()
+    t.end()
+  })
+})
+
+tape('shader variants - #version', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  gl.registerShaderTemplate('quad', {
+    vertex: '#version 300 es\nin vec2 position;\nvoid main() { gl_Position = vec4(position, 0.0, 1.0); }',
+    fragment: '#version 300 es\nprecision mediump float;\nout vec4 color;\n' +
+      'void main() { color = vec4(SCALE); }',
+    features: ['SCALE']
+  })
+
+  const program = gl.getVariant('quad', { SCALE: 0.5 })
+  t.equals(gl.getProgramParameter(program, gl.LINK_STATUS), true, 'defines follow #version')
+
+  gl.registerShaderTemplate('commented', {
+    vertex: '// position only\n\n/* a block\n   comment */ #version 300 es\n' +
+      'in vec2 position;\nvoid main() { gl_Position = vec4(position, 0.0, 1.0); }',
+    fragment: '\n  #version 300 es\nprecision mediump float;\nout vec4 color;\n' +
+      'void main() { color = vec4(SCALE); }',
+    features: ['SCALE']
+  })
+  const commented = gl.getVariant('commented', { SCALE: 0.5 })
+  t.equals(gl.getProgramParameter(commented, gl.LINK_STATUS), true,
+    'comments and blank lines before #version')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('shader variants - eviction', function (t) {
+  const gl = createContext(1, 1)
+  register(gl)
+
+  const first = gl.getVariant('quad', { ALPHA: '0.0' })
+  gl.useProgram(first)
+  const second = gl.getVariant('quad', { ALPHA: '1.0' })
+  for (let i = 2; i <= MAX_VARIANTS; ++i) {
+    gl.getVariant('quad', { ALPHA: i + '.0' })
+  }
+  t.notOk(gl.isProgram(second), 'least recently used variant is deleted')
+  t.ok(gl.isProgram(first), 'program in use is kept')
+  t.equals(gl.getVariant('quad', { ALPHA: '0.0' }), first, 'program in use is still cached')
+
+  const rebuilt = gl.getVariant('quad', { ALPHA: '1.0' })
+  t.notEqual(rebuilt, second, 'evicted variant is rebuilt')
+  t.equals(gl.getProgramParameter(rebuilt, gl.LINK_STATUS), true, 'rebuilt variant is linked')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
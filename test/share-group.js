@@ -0,0 +1,86 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const setupShader = require('./util/make-program')
+
+const VERTEX_SHADER = `
+attribute vec2 position;
+void main() {
+  gl_Position = vec4(position, 0.0, 1.0);
+}`
+
+const FRAGMENT_SHADER = `
+precision mediump float;
+uniform sampler2D image;
+void main() {
+  gl_FragColor = texture2D(image, vec2(0.5));
+}`
+
+function createTexture (gl, color) {
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.NEAREST)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 1, 1, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(color))
+  return texture
+}
+
+function createQuad (gl) {
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([-1, -1, 1, -1, -1, 1, 1, 1]), gl.STATIC_DRAW)
+  return buffer
+}
+
+function draw (gl, program, buffer, texture) {
+  gl.useProgram(program)
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.enableVertexAttribArray(0)
+  gl.vertexAttribPointer(0, 2, gl.FLOAT, false, 0, 0)
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.drawArrays(gl.TRIANGLE_STRIP, 0, 4)
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  return Array.from(pixels)
+}
+
+tape('share group - objects are usable in every context', function (t) {
+  const a = createContext(1, 1)
+  const b = createContext(2, 2, { shareWith: a })
+  t.ok(b, 'created shared context')
+
+  const program = setupShader(a, VERTEX_SHADER, FRAGMENT_SHADER, { position: 0 })
+  const buffer = createQuad(a)
+  const texture = createTexture(a, [10, 20, 30, 255])
+
+  t.same(draw(b, program, buffer, texture), [10, 20, 30, 255], 'drawn with objects of the other context')
+  t.equals(b.getError(), b.NO_ERROR, 'no errors')
+
+  const framebuffer = a.createFramebuffer()
+  b.bindFramebuffer(b.FRAMEBUFFER, framebuffer)
+  t.equals(b.getError(), b.INVALID_OPERATION, 'framebuffers are not shared')
+
+  const c = createContext(1, 1)
+  c.bindTexture(c.TEXTURE_2D, texture)
+  t.equals(c.getError(), c.INVALID_OPERATION, 'other contexts are not in the group')
+
+  a.destroy()
+  t.same(draw(b, program, buffer, texture), [10, 20, 30, 255], 'objects outlive the context that created them')
+  b.deleteTexture(texture)
+  t.equals(b.getError(), b.NO_ERROR, 'deleted by the remaining context')
+
+  b.destroy()
+  c.destroy()
+  t.end()
+})
+
+tape('share group - options', function (t) {
+  const gl = createContext(1, 1)
+  t.throws(() => createContext(1, 1, { shareWith: {} }), TypeError, 'not a context')
+  t.throws(() => createContext(1, 1, { shareWith: gl, createWebGL2Context: true }), TypeError,
+    'different version')
+
+  gl.destroy()
+  t.equals(createContext(1, 1, { shareWith: gl }), null, 'destroyed context')
+  t.end()
+})
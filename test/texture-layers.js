@@ -0,0 +1,86 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function readLayer (gl, texture, layer) {
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTextureLayer(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, texture, 0, layer)
+  const pixels = new Uint8Array(2 * 2 * 4)
+  gl.readPixels(0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  gl.deleteFramebuffer(framebuffer)
+  return Array.from(pixels)
+}
+
+function createArrayTexture (gl, depth) {
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D_ARRAY, texture)
+  gl.texStorage3D(gl.TEXTURE_2D_ARRAY, 1, gl.RGBA8, 2, 2, depth)
+  return texture
+}
+
+tape('texSubImage3DLayers - separate images', function (t) {
+  const gl = createContext(2, 2, { createWebGL2Context: true })
+
+  const texture = createArrayTexture(gl, 3)
+  const layers = [1, 2, 3].map((value) => new Uint8Array(16).fill(value))
+  gl.texSubImage3DLayers(gl.TEXTURE_2D_ARRAY, 0, 0, 0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, layers)
+  t.equals(gl.getError(), gl.NO_ERROR, 'uploaded')
+
+  for (let i = 0; i < layers.length; ++i) {
+    t.same(readLayer(gl, texture, i), Array.from(layers[i]), 'layer ' + i)
+  }
+
+  gl.texSubImage3DLayers(gl.TEXTURE_2D_ARRAY, 0, 0, 0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, [new Uint8Array(15)])
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'short layer')
+
+  const unpackBuffer = gl.createBuffer()
+  gl.bindBuffer(gl.PIXEL_UNPACK_BUFFER, unpackBuffer)
+  gl.bufferData(gl.PIXEL_UNPACK_BUFFER, 64, gl.STATIC_DRAW)
+  gl.texSubImage3DLayers(gl.TEXTURE_2D_ARRAY, 0, 0, 0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, layers)
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'pixel unpack buffer bound')
+  gl.bindBuffer(gl.PIXEL_UNPACK_BUFFER, null)
+  t.same(readLayer(gl, texture, 0), Array.from(layers[0]), 'texture unchanged')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texSubImage3DLayers - offsets into one buffer', function (t) {
+  const gl = createContext(2, 2, { createWebGL2Context: true })
+
+  const texture = createArrayTexture(gl, 4)
+  const buffer = new Uint8Array(64)
+  for (let i = 0; i < 4; ++i) {
+    buffer.fill(10 + i, i * 16, i * 16 + 16)
+  }
+
+  // Out of order, so the layers have to be staged
+  gl.texSubImage3DLayers(gl.TEXTURE_2D_ARRAY, 0, 0, 0, 1, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, {
+    buffer,
+    offsets: [32, 0]
+  })
+  t.equals(gl.getError(), gl.NO_ERROR, 'staged upload')
+  t.same(readLayer(gl, texture, 1), new Array(16).fill(12), 'layer 1')
+  t.same(readLayer(gl, texture, 2), new Array(16).fill(10), 'layer 2')
+
+  // Back to back, uploaded in place
+  gl.texSubImage3DLayers(gl.TEXTURE_2D_ARRAY, 0, 0, 0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, {
+    buffer,
+    offsets: new Uint32Array([0, 16, 32, 48])
+  })
+  t.equals(gl.getError(), gl.NO_ERROR, 'in place upload')
+  t.same(readLayer(gl, texture, 3), new Array(16).fill(13), 'layer 3')
+
+  t.throws(function () {
+    gl.texSubImage3DLayers(gl.TEXTURE_2D_ARRAY, 0, 0, 0, 0, 2, 2, gl.RGBA, gl.UNSIGNED_BYTE, {
+      buffer,
+      offsets: [65]
+    })
+  }, TypeError, 'offset past the end')
+
+  gl.destroy()
+  t.end()
+})
@@ -0,0 +1,177 @@
+'use strict'
+
+const tape = require('tape')
+const zlib = require('zlib')
+const createContext = require('../index')
+
+function createTile (gl, value) {
+  const pixels = new Uint8Array(4 * 4 * 4).fill(value)
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.NEAREST)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  return { texture, pixels }
+}
+
+function readTexture (gl, texture) {
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  const pixels = new Uint8Array(4 * 4 * 4)
+  gl.readPixels(0, 0, 4, 4, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  gl.deleteFramebuffer(framebuffer)
+  return pixels
+}
+
+tape('texture memory budget - least recently bound textures are evicted', function (t) {
+  const gl = createContext(4, 4, { memoryBudget: 128 })
+
+  const a = createTile(gl, 1)
+  const b = createTile(gl, 2)
+  t.equals(gl.getTextureMemoryStats().residentBytes, 128, 'both tiles resident')
+
+  gl.setTextureEvictable(a.texture, { data: a.pixels })
+  gl.setTextureEvictable(b.texture, { data: zlib.gzipSync(b.pixels), compression: 'gzip' })
+  t.equals(gl.getError(), gl.NO_ERROR, 'tiles marked evictable')
+
+  createTile(gl, 3)
+  let stats = gl.getTextureMemoryStats()
+  t.equals(stats.evictions, 1, 'one tile evicted')
+  t.equals(stats.evictedTextures, 1, 'one tile released')
+  t.equals(stats.residentBytes, 128, 'within budget')
+
+  gl.bindTexture(gl.TEXTURE_2D, a.texture)
+  t.equals(gl.getError(), gl.NO_ERROR, 'evicted tile bound')
+  stats = gl.getTextureMemoryStats()
+  t.equals(stats.restores, 1, 'tile restored')
+  t.equals(stats.evictions, 2, 'next tile evicted')
+  gl.bindTexture(gl.TEXTURE_2D, null)
+
+  t.same(Array.from(readTexture(gl, a.texture)), Array.from(a.pixels), 'restored contents')
+  gl.bindTexture(gl.TEXTURE_2D, b.texture)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  t.same(Array.from(readTexture(gl, b.texture)), Array.from(b.pixels), 'decompressed contents')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture memory budget - pinned textures', function (t) {
+  const gl = createContext(4, 4, { memoryBudget: 0 })
+
+  const a = createTile(gl, 1)
+  const unbacked = gl.createTexture()
+  gl.setTextureEvictable(unbacked, { data: a.pixels })
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'textures without level 0 can not be evicted')
+
+  gl.bindTexture(gl.TEXTURE_2D, a.texture)
+  gl.setTextureEvictable(a.texture, { data: a.pixels })
+  t.equals(gl.getTextureMemoryStats().evictions, 0, 'bound textures are not evicted')
+
+  gl.texSubImage2D(gl.TEXTURE_2D, 0, 0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(4))
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  const stats = gl.getTextureMemoryStats()
+  t.equals(stats.evictableTextures, 0, 'modified texture is pinned')
+  t.equals(stats.evictions, 0, 'nothing evicted')
+
+  gl.deleteTexture(a.texture)
+  t.equals(gl.getTextureMemoryStats().residentBytes, 0, 'deleted texture released')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture memory budget - uploaded mip levels', function (t) {
+  const gl = createContext(4, 4, { memoryBudget: 0 })
+
+  const a = createTile(gl, 1)
+  gl.bindTexture(gl.TEXTURE_2D, a.texture)
+  gl.texImage2D(gl.TEXTURE_2D, 1, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(16))
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  gl.setTextureEvictable(a.texture, { data: a.pixels })
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'restoring would replace them')
+
+  gl.bindTexture(gl.TEXTURE_2D, a.texture)
+  gl.generateMipmap(gl.TEXTURE_2D)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  gl.setTextureEvictable(a.texture, { data: a.pixels })
+  t.equals(gl.getError(), gl.NO_ERROR, 'generated mipmaps can be restored')
+  t.equals(gl.getTextureMemoryStats().evictions, 1, 'evicted')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture memory budget - failed restore', function (t) {
+  const gl = createContext(4, 4, { memoryBudget: 0, memoryLimit: 1024 })
+
+  const a = createTile(gl, 1)
+  gl.setTextureEvictable(a.texture, { data: a.pixels })
+  t.equals(gl.getTextureMemoryStats().evictions, 1, 'evicted')
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, 1024, gl.STATIC_DRAW)
+  gl.bindTexture(gl.TEXTURE_2D, a.texture)
+  t.equals(gl.getError(), gl.OUT_OF_MEMORY, 'failure reported')
+  const stats = gl.getTextureMemoryStats()
+  t.equals(stats.evictableTextures, 0, 'no longer evictable')
+  t.equals(stats.residentBytes, 0, 'nothing resident')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture memory budget - shared textures', function (t) {
+  const owner = createContext(4, 4, { memoryBudget: 64 })
+  const other = createContext(4, 4, { shareWith: owner })
+
+  const a = createTile(owner, 1)
+  owner.setTextureEvictable(a.texture, { data: a.pixels })
+  other.bindTexture(other.TEXTURE_2D, a.texture)
+  createTile(owner, 2)
+  t.equals(owner.getTextureMemoryStats().evictions, 0, 'textures bound in another context stay')
+
+  other.bindTexture(other.TEXTURE_2D, null)
+  createTile(owner, 3)
+  t.equals(owner.getTextureMemoryStats().evictions, 1, 'evicted once unbound')
+
+  other.bindTexture(other.TEXTURE_2D, a.texture)
+  const stats = owner.getTextureMemoryStats()
+  t.equals(stats.restores, 1, 'binding in another context restores it in the owner budget')
+  t.equals(other.getTextureMemoryStats().restores, 0, 'not counted by the other context')
+  t.same(Array.from(readTexture(other, a.texture)), Array.from(a.pixels), 'restored contents')
+  t.equals(other.getError(), other.NO_ERROR, 'no errors')
+
+  other.destroy()
+  owner.destroy()
+  t.end()
+})
+
+tape('texture memory budget - promoted textures', function (t) {
+  const gl = createContext(4, 4, { memoryBudget: 0, promoteTextureStorage: true })
+
+  const pixels = new Uint8Array(4 * 4 * 4).fill(7)
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.generateMipmap(gl.TEXTURE_2D)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  gl.setTextureEvictable(texture, { data: pixels })
+  t.equals(gl.getTextureMemoryStats().evictions, 1, 'promoted texture evicted')
+
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  t.equals(gl.getError(), gl.NO_ERROR, 'evicted texture bound')
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), texture, 'wrapper follows the GL texture')
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  t.same(Array.from(readTexture(gl, texture)), Array.from(pixels), 'restored contents')
+
+  const stats = gl.getTextureMemoryStats()
+  t.equals(stats.evictableTextures, 0, 'attached textures are pinned')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
@@ -0,0 +1,189 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const drawTriangle = require('./util/draw-triangle')
+const setupShader = require('./util/make-program')
+
+function uploadChain (gl, size) {
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  for (let level = 0; size >= 1; ++level, size >>= 1) {
+    gl.texImage2D(
+      gl.TEXTURE_2D,
+      level,
+      gl.RGBA,
+      size, size,
+      0,
+      gl.RGBA,
+      gl.UNSIGNED_BYTE,
+      new Uint8Array(size * size * 4).fill(level))
+  }
+  return texture
+}
+
+tape('texture storage promotion - full mip chain', function (t) {
+  const gl = createContext(16, 16, { promoteTextureStorage: true })
+
+  uploadChain(gl, 8)
+  t.equals(gl.getError(), gl.NO_ERROR, 'chain uploaded')
+
+  const stats = gl.getTextureStorageStats()
+  t.equals(stats.promotedTextures, 1, 'texture promoted')
+  t.equals(stats.avoidedReallocations, 3, 'reallocations avoided')
+  t.equals(stats.pendingMipChains, 0, 'nothing pending')
+  t.equals(gl.getTexParameter(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER), gl.NEAREST_MIPMAP_LINEAR, 'parameters kept')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture storage promotion - generateMipmap', function (t) {
+  const gl = createContext(16, 16, { promoteTextureStorage: true })
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 16, 16, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getTextureStorageStats().pendingMipChains, 1, 'level 0 held back')
+
+  gl.generateMipmap(gl.TEXTURE_2D)
+  t.equals(gl.getError(), gl.NO_ERROR, 'mipmaps generated')
+
+  const stats = gl.getTextureStorageStats()
+  t.equals(stats.promotedTextures, 1, 'texture promoted')
+  t.equals(stats.avoidedReallocations, 4, 'reallocations avoided')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture storage promotion - redefining a promoted texture', function (t) {
+  const gl = createContext(16, 16, { promoteTextureStorage: true })
+
+  const texture = uploadChain(gl, 8)
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 8, 8, 0, gl.RGBA, gl.UNSIGNED_BYTE,
+    new Uint8Array(8 * 8 * 4).fill(9))
+  t.equals(gl.getError(), gl.NO_ERROR, 'level redefined with the same shape')
+
+  gl.texImage2D(gl.TEXTURE_2D, 1, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.NO_ERROR, 'level redefined with another shape')
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), texture, 'still bound')
+  t.ok(gl.isTexture(texture), 'still a texture')
+  t.equals(gl.getTexParameter(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER), gl.NEAREST_MIPMAP_LINEAR, 'parameters kept')
+
+  t.equals(gl.checkFramebufferStatus(gl.FRAMEBUFFER), gl.FRAMEBUFFER_COMPLETE, 'still attached')
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [9, 9, 9, 9], 'other levels kept')
+
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 16, 16, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.NO_ERROR, 'mutable from then on')
+
+  gl.deleteTexture(texture)
+  t.notOk(gl.isTexture(texture), 'deleted')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no error')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture storage promotion - incomplete chain is demoted', function (t) {
+  const gl = createContext(16, 16, { promoteTextureStorage: true })
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(64).fill(255))
+  gl.texSubImage2D(gl.TEXTURE_2D, 0, 0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(4))
+  t.equals(gl.getError(), gl.NO_ERROR, 'sub image uploaded')
+
+  // The texture must still be mutable after demotion
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.NO_ERROR, 'texture can be respecified')
+
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+
+  const stats = gl.getTextureStorageStats()
+  t.equals(stats.promotedTextures, 0, 'nothing promoted')
+  t.equals(stats.demotedMipChains, 2, 'chains demoted')
+  t.equals(stats.pendingMipChains, 0, 'nothing pending')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture storage promotion - draws only complete bound chains', function (t) {
+  const gl = createContext(16, 16, { promoteTextureStorage: true })
+
+  const program = setupShader(gl,
+    'attribute vec2 position; void main() { gl_Position = vec4(position, 0, 1); }',
+    'void main() { gl_FragColor = vec4(1); }')
+  gl.bindAttribLocation(program, 0, 'position')
+  gl.linkProgram(program)
+  gl.useProgram(program)
+
+  const loading = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, loading)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  drawTriangle(gl)
+  t.equals(gl.getTextureStorageStats().pendingMipChains, 1, 'unbound chain still pending')
+
+  gl.bindTexture(gl.TEXTURE_2D, loading)
+  gl.texImage2D(gl.TEXTURE_2D, 1, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  gl.activeTexture(gl.TEXTURE1)
+  drawTriangle(gl)
+  t.equals(gl.getTextureStorageStats().pendingMipChains, 0, 'chain bound to another unit completed')
+  t.equals(gl.getTextureStorageStats().demotedMipChains, 1, 'chain demoted')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no error')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('texture storage promotion - shared contexts', function (t) {
+  const gl = createContext(16, 16, { promoteTextureStorage: true })
+
+  const texture = uploadChain(gl, 8)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 8, 8, 0, gl.RGBA, gl.UNSIGNED_BYTE,
+    new Uint8Array(8 * 8 * 4).fill(9))
+  t.equals(gl.getTextureStorageStats().promotedTextures, 1, 'texture promoted')
+
+  const other = createContext(16, 16, { promoteTextureStorage: true, shareWith: gl })
+  t.ok(gl.isTexture(texture), 'texture kept across sharing')
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), texture, 'still bound')
+  gl.texImage2D(gl.TEXTURE_2D, 1, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  t.equals(gl.getError(), gl.NO_ERROR, 'texture mutable once shared')
+
+  const pixels = new Uint8Array(4)
+  const framebuffer = other.createFramebuffer()
+  other.bindFramebuffer(other.FRAMEBUFFER, framebuffer)
+  other.framebufferTexture2D(other.FRAMEBUFFER, other.COLOR_ATTACHMENT0, other.TEXTURE_2D, texture, 0)
+  other.readPixels(0, 0, 1, 1, other.RGBA, other.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [9, 9, 9, 9], 'levels visible to the other context')
+
+  uploadChain(gl, 8)
+  uploadChain(other, 8)
+  t.equals(gl.getTextureStorageStats().promotedTextures, 1, 'nothing more promoted')
+  t.equals(other.getTextureStorageStats().promotedTextures, 0, 'nothing promoted while shared')
+
+  other.destroy()
+  gl.destroy()
+  t.end()
+})
+
+tape('texture storage promotion - disabled by default', function (t) {
+  const gl = createContext(16, 16)
+
+  uploadChain(gl, 8)
+  t.equals(gl.getError(), gl.NO_ERROR, 'chain uploaded')
+  t.equals(gl.getTextureStorageStats().promotedTextures, 0, 'nothing promoted')
+
+  gl.destroy()
+  t.end()
+})
@@ -0,0 +1,56 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function evictableTexture (gl) {
+  const pixels = new Uint8Array(16 * 16 * 4)
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 16, 16, 0, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.setTextureEvictable(texture, { data: pixels })
+  gl.bindTexture(gl.TEXTURE_2D, null)
+  return texture
+}
+
+tape('trim memory - levels', function (t) {
+  const gl = createContext(16, 16)
+  const texture = evictableTexture(gl)
+
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+
+  gl.trimMemory(1)
+  t.equals(gl.getTextureMemoryStats().evictedTextures, 0, 'level 1 keeps textures')
+  t.equals(gl.getError(), gl.NO_ERROR, 'level 1')
+
+  t.ok(gl.trimMemory(2) >= 16 * 16 * 4, 'released bytes include the evicted texture')
+  t.equals(gl.getTextureMemoryStats().evictedTextures, 1, 'level 2 evicts textures')
+  t.equals(gl.getError(), gl.NO_ERROR, 'level 2')
+
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  t.equals(gl.getTextureMemoryStats().evictedTextures, 0, 'restored when bound')
+
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [255, 0, 0, 255], 'drawing buffer kept by trimming')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('trim memory - memory pressure', function (t) {
+  const gl = createContext(16, 16, { memoryPressure: { heapUsed: 1, level: 2 } })
+  evictableTexture(gl)
+
+  setTimeout(function () {
+    t.equals(gl.getTextureMemoryStats().evictedTextures, 1, 'trimmed over the threshold')
+    gl.destroy()
+    t.end()
+  }, 1500)
+})
+
+tape('trim memory - program cache', function (t) {
+  t.ok(createContext.trimProgramCache() >= 0, 'process-wide program caches trimmed explicitly')
+  t.end()
+})
@@ -0,0 +1,55 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const { attachShaders } = require('./util/make-program')
+
+const VERTEX_SHADER = `
+attribute vec2 position;
+void main() {
+  gl_Position = vec4(position, 0.0, 1.0);
+}`
+
+const FRAGMENT_SHADER = `
+precision mediump float;
+uniform vec4 color;
+uniform float weights[3];
+void main() {
+  gl_FragColor = color * (weights[0] + weights[1] + weights[2]);
+}`
+
+tape('uniform locations - lookups', function (t) {
+  const gl = createContext(1, 1)
+  const program = attachShaders(gl, VERTEX_SHADER, FRAGMENT_SHADER)
+
+  t.equals(gl.getUniformLocation(program, 'color'), null, 'unlinked program')
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'unlinked program error')
+
+  gl.linkProgram(program)
+  const color = gl.getUniformLocation(program, 'color')
+  t.ok(color, 'found uniform')
+  t.equals(gl.getUniformLocation(program, 'color'), color, 'locations are reused')
+  t.equals(gl.getUniformLocation(program, 'missing'), null, 'missing uniform')
+  t.equals(gl.getUniformLocation(program, 'weights[3]'), null, 'element out of range')
+
+  const weights = gl.getUniformLocation(program, 'weights[0]')
+  const last = gl.getUniformLocation(program, 'weights[2]')
+  t.ok(weights && last, 'array elements')
+  t.notEqual(weights, last, 'distinct elements')
+
+  gl.useProgram(program)
+  gl.uniform1fv(weights, [1, 2, 3])
+  t.equals(gl.getUniform(program, last), 3, 'array upload reaches every element')
+  gl.uniform1f(last, 5)
+  t.same(Array.from([0, 1, 2], (i) => gl.getUniform(program, gl.getUniformLocation(program, 'weights[' + i + ']'))),
+    [1, 2, 5], 'element upload')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.linkProgram(program)
+  t.notEqual(gl.getUniformLocation(program, 'color'), color, 'relinking invalidates locations')
+  gl.uniform4f(color, 1, 1, 1, 1)
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'stale location rejected')
+
+  gl.destroy()
+  t.end()
+})
@@ -2,14 +2,27 @@
 
 const compileShader = require('./make-shader')
 
-module.exports = function setupShader (gl, VERT_SRC, FRAG_SRC) {
+// Compiles both shaders and attaches them to a new program, leaving the
+// caller to link it
+function attachShaders (gl, VERT_SRC, FRAG_SRC) {
   const fragShader = compileShader(gl, gl.FRAGMENT_SHADER, FRAG_SRC)
   const vertShader = compileShader(gl, gl.VERTEX_SHADER, VERT_SRC)
 
   const program = gl.createProgram()
   gl.attachShader(program, fragShader)
   gl.attachShader(program, vertShader)
+
+  return program
+}
+
+module.exports = function setupShader (gl, VERT_SRC, FRAG_SRC, attributes = {}) {
+  const program = attachShaders(gl, VERT_SRC, FRAG_SRC)
+  for (const name of Object.keys(attributes)) {
+    gl.bindAttribLocation(program, attributes[name], name)
+  }
   gl.linkProgram(program)
 
   return program
 }
+
+module.exports.attachShaders = attachShaders
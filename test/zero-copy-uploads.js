@@ -0,0 +1,88 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function readTexture (gl, texture, width, height) {
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  const pixels = new Uint8Array(width * height * 4)
+  gl.readPixels(0, 0, width, height, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  gl.deleteFramebuffer(framebuffer)
+  return pixels
+}
+
+tape('zero copy uploads - texImage2D sources', function (t) {
+  const gl = createContext(2, 2)
+
+  const shared = new SharedArrayBuffer(4 + 16)
+  const expected = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16]
+  new Uint8Array(shared, 4).set(expected)
+
+  const sources = {
+    'SharedArrayBuffer view with offset': new Uint8Array(shared, 4, 16),
+    Uint8ClampedArray: new Uint8ClampedArray(expected),
+    Buffer: Buffer.from(expected),
+    ArrayBuffer: new Uint8Array(expected).buffer
+  }
+
+  for (const [name, source] of Object.entries(sources)) {
+    const texture = gl.createTexture()
+    gl.bindTexture(gl.TEXTURE_2D, texture)
+    gl.texParameteri(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.NEAREST)
+    gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, source)
+    t.equals(gl.getError(), gl.NO_ERROR, name + ' uploaded')
+    t.same(Array.from(readTexture(gl, texture, 2, 2)), expected, name + ' contents')
+  }
+
+  gl.destroy()
+  t.end()
+})
+
+tape('zero copy uploads - view type must match the pixel type', function (t) {
+  const gl = createContext(2, 2)
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Float32Array(16))
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'Float32Array with UNSIGNED_BYTE')
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 2, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, new DataView(new ArrayBuffer(16)))
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'DataView')
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGB, 2, 2, 0, gl.RGB, gl.UNSIGNED_SHORT_5_6_5, new Uint16Array(4))
+  t.equals(gl.getError(), gl.NO_ERROR, 'Uint16Array with a packed type')
+  gl.texSubImage2D(gl.TEXTURE_2D, 0, 0, 0, 2, 2, gl.RGB, gl.UNSIGNED_SHORT_5_6_5, new Int16Array(4))
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'texSubImage2D with Int16Array')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('zero copy uploads - bufferData sources', function (t) {
+  const gl = createContext(2, 2)
+
+  const shared = new SharedArrayBuffer(64)
+  const sources = {
+    'SharedArrayBuffer view with offset': [new Float32Array(shared, 16, 8), 32],
+    DataView: [new DataView(shared, 8, 24), 24],
+    Buffer: [Buffer.alloc(12), 12],
+    SharedArrayBuffer: [shared, 64]
+  }
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  for (const [name, [source, size]] of Object.entries(sources)) {
+    gl.bufferData(gl.ARRAY_BUFFER, source, gl.STATIC_DRAW)
+    t.equals(gl.getError(), gl.NO_ERROR, name + ' uploaded')
+    t.equals(gl.getBufferParameter(gl.ARRAY_BUFFER, gl.BUFFER_SIZE), size, name + ' size')
+  }
+
+  gl.bufferSubData(gl.ARRAY_BUFFER, 32, new DataView(shared, 0, 32))
+  t.equals(gl.getError(), gl.NO_ERROR, 'bufferSubData from a DataView')
+  gl.bufferSubData(gl.ARRAY_BUFFER, 48, new DataView(shared, 0, 32))
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'bufferSubData out of range')
+
+  gl.destroy()
+  t.end()
+})